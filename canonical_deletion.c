@@ -0,0 +1,259 @@
+#include "graph_plus.h"
+#include "graph_util.h"
+#include "canonical_deletion.h"
+#include "instrument.h"
+
+long long canonicalisation_calls = 0;
+
+bool use_distance_profile_tier = false;
+
+void delete_neighbourhood(int v, graph *g)
+{
+    while (g[v]) {
+        int nb;
+        TAKEBIT(nb, g[v]);
+        DELELEMENT(&g[nb], v);
+    }
+}
+
+bool deletion_is_better(int v, graph *g, int n, int min_deg, int max_deg, int tentativeness_level)
+{
+    INSTR_SCOPE(PHASE_DELETION_IS_BETTER, n);
+
+    graph g0[MAXN], g1[MAXN];
+    for (int i=0; i<n; i++) {
+        g0[i] = g[i];
+        g1[i] = g[i];
+    }
+    // In g0, we delete vertex n-1 and its edges, and don't relabel vertices
+    // In g1, we delete vertex v and its edges, and relabel vertex n-1 to v
+    delete_neighbourhood(n-1, g0);
+    delete_neighbourhood(n-1, g1);
+    delete_neighbourhood(v, g1);
+    setword neighbours = g[n-1];
+    while (neighbours) {
+        int nb;
+        TAKEBIT(nb, neighbours);
+        if (nb != v) {
+            ADDONEEDGE(g1, v, nb, 1);
+        }
+    }
+
+    setword sw0a = 0;
+    setword sw1a = 0;
+    for (int deg=min_deg; deg<=max_deg; deg++) {
+        setword sw0 = 0;
+        setword sw1 = 0;
+        for (int i=0; i<n; i++) {
+            if (POPCOUNT(g0[i]) == deg) {
+                sw0 ^= g0[i];
+                sw0a ^= g0[i];
+            }
+            if (POPCOUNT(g1[i]) == deg) {
+                sw1 ^= g1[i];
+                sw1a ^= g1[i];
+            }
+        }
+        INSTR_TIER_REACHED(TIER_DEGREE_CLASS_XOR);
+        int pc0 = POPCOUNT(sw0);
+        int pc1 = POPCOUNT(sw1);
+        if (pc0 < pc1)
+            return true;
+        if (pc0 > pc1)
+            return false;
+        pc0 = POPCOUNT(sw0a);
+        pc1 = POPCOUNT(sw1a);
+        if (pc0 < pc1)
+            return true;
+        if (pc0 > pc1)
+            return false;
+    }
+
+    if (tentativeness_level != 0) {
+        INSTR_TIER_REACHED(TIER_TENTATIVE);
+        return false;
+    }
+
+    INSTR_TIER_REACHED(TIER_NAUTY);
+    graph g1_canon[MAXN];
+    INSTR_ENTER(PHASE_CANON_DELETION, n);
+    make_canonical(g1, n-1, g1_canon, NULL);
+    INSTR_LEAVE();
+    canonicalisation_calls++;
+
+    return compare_graphs(g0, g1_canon, n-1) == GREATER_THAN;
+}
+
+int modified_nb_deg_sum(graph *g, int v, setword s) {
+    int deg_sum = 0;
+    setword nb = g[v];
+    while (nb) {
+        int w;
+        TAKEBIT(w, nb);
+        deg_sum += POPCOUNT(g[w] & s);
+    }
+    return deg_sum;
+}
+
+// Sets profile[d] to the number of vertices at distance d from v, for d from
+// 1 until there are none
+static void distance_profile(graph *g, int n, int v, int *profile)
+{
+    setword seen = bit[v];
+    setword frontier = bit[v];
+    for (int d=1; d<n; d++) {
+        setword next = 0;
+        while (frontier) {
+            int w;
+            TAKEBIT(w, frontier);
+            next |= g[w];
+        }
+        frontier = next & ~seen;
+        seen |= frontier;
+        profile[d] = POPCOUNT(frontier);
+        if (!frontier)
+            break;
+    }
+}
+
+// Compares distance profiles lexicographically
+static int compare_distance_profiles(int *profile0, int *profile1, int n)
+{
+    for (int d=1; d<n; d++) {
+        if (profile0[d] != profile1[d])
+            return profile0[d] < profile1[d] ? -1 : 1;
+        if (!profile0[d])
+            break;
+    }
+    return 0;
+}
+
+// For correctness, we have to be really careful about what rules we
+// put in here.
+// Assumption: the last vertex of g has degree equal to min_deg
+bool deletion_is_canonical(graph *g, int n, int min_deg, int max_deg,
+        int tentativeness_level, setword vertices_of_min_deg)
+{
+    INSTR_SCOPE(PHASE_DELETION_NB_COUNT_TIER, n);
+    INSTR_TIER_RESET();
+
+    // Each tier is applied to all of the rivals left by the one before, so
+    // that the instrumented build can time the tiers separately
+    int n0 = POPCOUNT(g[n-1] & vertices_of_min_deg);
+    setword vertices_to_check_deletion = 0;
+    setword tmp = vertices_of_min_deg ^ bit[n-1];
+    while (tmp) {
+        int i;
+        TAKEBIT(i, tmp);
+        INSTR_TIER_REACHED(TIER_MIN_DEG_NB_COUNT);
+        int n1 = POPCOUNT(g[i] & vertices_of_min_deg);
+        if (n1 > n0) {
+            INSTR_TIER_DECISION(n, tentativeness_level, false);
+            return false;
+        } else if (n1 == n0) {
+            vertices_to_check_deletion |= bit[i];
+        }
+    }
+
+    if (vertices_to_check_deletion) {
+        INSTR_SWITCH(PHASE_DELETION_MODIFIED_NDS_TIER);
+        INSTR_TIER_REACHED(TIER_MODIFIED_NB_DEG_SUM);
+        int nds0mod = modified_nb_deg_sum(g, n-1, vertices_of_min_deg);
+        tmp = vertices_to_check_deletion;
+        vertices_to_check_deletion = 0;
+        while (tmp) {
+            int i;
+            TAKEBIT(i, tmp);
+            int nds1mod = modified_nb_deg_sum(g, i, vertices_of_min_deg);
+            if (nds1mod < nds0mod) {
+                INSTR_TIER_DECISION(n, tentativeness_level, false);
+                return false;
+            } else if (nds1mod == nds0mod) {
+                vertices_to_check_deletion |= bit[i];
+            }
+        }
+    }
+
+    if (vertices_to_check_deletion) {
+        INSTR_SWITCH(PHASE_DELETION_NDS_TIER);
+        INSTR_TIER_REACHED(TIER_NB_DEG_SUM);
+        int nds0 = nb_deg_sum_self_contained(g, n-1);
+        tmp = vertices_to_check_deletion;
+        vertices_to_check_deletion = 0;
+        while (tmp) {
+            int i;
+            TAKEBIT(i, tmp);
+            int nds1 = nb_deg_sum_self_contained(g, i);
+            if (nds1 < nds0) {
+                INSTR_TIER_DECISION(n, tentativeness_level, false);
+                return false;
+            } else if (nds1 == nds0) {
+                vertices_to_check_deletion |= bit[i];
+            }
+        }
+    }
+
+    if (!vertices_to_check_deletion) {
+        INSTR_TIER_DECISION(n, tentativeness_level, true);
+        return true;
+    }
+
+    // In a regular graph, every vertex ties on the tests above, and on
+    // weighted_nb_nb_deg_sum.  The greatest distance profile is preferred.
+    if (use_distance_profile_tier && min_deg == max_deg) {
+        INSTR_SWITCH(PHASE_DELETION_DISTANCE_PROFILE_TIER);
+        INSTR_TIER_REACHED(TIER_DISTANCE_PROFILE);
+        int profile0[MAXN];
+        distance_profile(g, n, n-1, profile0);
+        tmp = vertices_to_check_deletion;
+        vertices_to_check_deletion = 0;
+        while (tmp) {
+            int v;
+            TAKEBIT(v, tmp);
+            int profile1[MAXN];
+            distance_profile(g, n, v, profile1);
+            int cmp = compare_distance_profiles(profile0, profile1, n);
+            if (cmp < 0) {
+                INSTR_TIER_DECISION(n, tentativeness_level, false);
+                return false;
+            } else if (cmp == 0) {
+                vertices_to_check_deletion |= bit[v];
+            }
+        }
+        if (!vertices_to_check_deletion) {
+            INSTR_TIER_DECISION(n, tentativeness_level, true);
+            return true;
+        }
+    }
+
+    INSTR_SWITCH(PHASE_DELETION_NNDS_TIER);
+    INSTR_TIER_REACHED(TIER_WEIGHTED_NB_NB_DEG_SUM);
+    unsigned long long nnds0 = weighted_nb_nb_deg_sum(g, n-1);
+    tmp = vertices_to_check_deletion;
+    vertices_to_check_deletion = 0;
+    while (tmp) {
+        int v;
+        TAKEBIT(v, tmp);
+        unsigned long long nnds1 = weighted_nb_nb_deg_sum(g, v);
+        if (nnds1 < nnds0) {
+            INSTR_TIER_DECISION(n, tentativeness_level, false);
+            return false;
+        } else if (nnds1 == nnds0) {
+            // Delay the expensive checks that use Nauty;
+            // if we're lucky, we won't need to do them at all.
+            vertices_to_check_deletion |= bit[v];
+        }
+    }
+
+    while (vertices_to_check_deletion) {
+        int v;
+        TAKEBIT(v, vertices_to_check_deletion);
+        if (deletion_is_better(v, g, n, min_deg, max_deg, tentativeness_level)) {
+            INSTR_TIER_DECISION(n, tentativeness_level, false);
+            return false;
+        }
+    }
+
+    INSTR_TIER_DECISION(n, tentativeness_level, true);
+    return true;
+}
@@ -0,0 +1,25 @@
+#include <stdbool.h>
+
+// The number of calls to make_canonical, including those made elsewhere
+// in the search
+extern long long canonicalisation_calls;
+
+void delete_neighbourhood(int v, graph *g);
+
+// Is deleting vertex v of g better than deleting vertex n-1?
+bool deletion_is_better(int v, graph *g, int n, int min_deg, int max_deg, int tentativeness_level);
+
+int modified_nb_deg_sum(graph *g, int v, setword s);
+
+// If set (in regular mode), the min-degree vertices of a regular graph, which
+// the degree-based tests can't tell apart, are compared by distance profile
+// before nauty is used.  It must not change during a search.
+extern bool use_distance_profile_tier;
+
+// Is deleting vertex n-1 of g the canonical deletion?  At tentativeness
+// levels above 0, nauty is not called, and ties that can't be resolved
+// without it are treated as canonical.
+// Assumption: the last vertex of g has degree equal to min_deg, and
+// vertices_of_min_deg is the set of vertices of g of degree min_deg
+bool deletion_is_canonical(graph *g, int n, int min_deg, int max_deg,
+        int tentativeness_level, setword vertices_of_min_deg);
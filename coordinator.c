@@ -0,0 +1,659 @@
+#include "graph_plus.h"
+#include "graph_output.h"
+#include "canonical_deletion.h"
+#include "coordinator.h"
+#include "progress.h"
+#include "protocol.h"
+#include "search.h"
+#include "util.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define MAX_WORKERS 1024
+
+// Seconds for which a worker keeps trying to connect
+#define CONNECT_TIMEOUT 60
+
+// A worker that had nothing to donate, perhaps because its lease had only
+// just started, is asked again after this many milliseconds
+#define DONATION_RETRY_MS 100
+
+enum LeaseState {LEASE_PENDING, LEASE_ACTIVE, LEASE_DONE, LEASE_CANCELLED};
+
+struct Lease {
+    struct GraphPlus gp;
+    enum LeaseState state;
+    int runs;             // the number of times the lease has been assigned
+    long long donor;      // the lease this was donated from, or -1
+    int donor_run;        // the run of the donor that it was donated from
+    // Leases whose graphs lie outside this lease's subtree as far as its
+    // workers are concerned, because they were donated from a run of an
+    // ancestor lease that was later reissued
+    long long *inherited_exclusions;
+    int num_inherited_exclusions;
+};
+
+static struct Lease *leases = NULL;
+static int num_leases = 0;
+static int leases_size = 0;
+
+struct Worker {
+    int fd;
+    long long lease;    // the index of the lease the worker holds, or -1
+    bool idle;          // waiting for a lease to become available
+    bool asked;         // a donation request is outstanding
+    bool exhausted;     // had nothing to donate when last asked
+    unsigned long long exhausted_at;  // when, in milliseconds (see now_ms)
+    unsigned long long lease_stamp;   // when the current lease was assigned
+};
+
+static unsigned long long lease_stamp = 0;
+static int num_donated_leases = 0;
+
+static struct Worker workers[MAX_WORKERS];
+static int num_workers = 0;
+
+static void add_lease(struct GraphPlus *gp)
+{
+    if (num_leases == leases_size) {
+        leases_size = leases_size ? 2 * leases_size : 1024;
+        struct Lease *new_leases = emalloc(leases_size * sizeof *leases);
+        if (num_leases)
+            memcpy(new_leases, leases, num_leases * sizeof *leases);
+        free(leases);
+        leases = new_leases;
+    }
+    leases[num_leases].gp = *gp;
+    leases[num_leases].gp.left = leases[num_leases].gp.right = NULL;
+    leases[num_leases].state = LEASE_PENDING;
+    leases[num_leases].runs = 0;
+    leases[num_leases].donor = -1;
+    leases[num_leases].donor_run = 0;
+    leases[num_leases].inherited_exclusions = NULL;
+    leases[num_leases].num_inherited_exclusions = 0;
+    num_leases++;
+}
+
+static long long find_pending_lease()
+{
+    // Pending leases are taken in order, apart from those returned by dead
+    // workers, which come before the cursor
+    static long long cursor = 0;
+    while (cursor < num_leases && leases[cursor].state != LEASE_PENDING)
+        cursor++;
+    if (cursor < num_leases)
+        return cursor;
+    for (long long i=0; i<num_leases; i++)
+        if (leases[i].state == LEASE_PENDING)
+            return i;
+    return -1;
+}
+
+// Returns the leases whose subtrees a worker must skip in the current run of
+// the lease: those donated from earlier runs of it, which were reissued, and
+// those inherited from its donor.  The caller frees the array.
+static int find_exclusions(long long lease_id, long long **exclusions)
+{
+    struct Lease *lease = &leases[lease_id];
+    int size = lease->num_inherited_exclusions;
+    if (lease->runs > 1)
+        for (long long i=0; i<num_leases; i++)
+            size += leases[i].donor == lease_id && leases[i].donor_run < lease->runs;
+    *exclusions = size ? emalloc(size * sizeof **exclusions) : NULL;
+    int count = lease->num_inherited_exclusions;
+    if (count)
+        memcpy(*exclusions, lease->inherited_exclusions, count * sizeof **exclusions);
+    if (lease->runs > 1)
+        for (long long i=0; i<num_leases; i++)
+            if (leases[i].donor == lease_id && leases[i].donor_run < lease->runs)
+                (*exclusions)[count++] = i;
+    return count;
+}
+
+// Sends the graphs of the leases to be excluded, which the worker skips when
+// it runs the lease that follows
+static bool send_exclusions(struct Worker *w, long long lease_id)
+{
+    long long *exclusions;
+    int num_exclusions = find_exclusions(lease_id, &exclusions);
+    int max_graphs = (MAX_MESSAGE_LEN - 4) / (4 + 8 * MAXN);
+    bool ok = true;
+    for (int i=0; ok && i<num_exclusions; i+=max_graphs) {
+        int count = num_exclusions - i < max_graphs ? num_exclusions - i : max_graphs;
+        struct Message m;
+        message_init(&m, MSG_EXCLUDE);
+        put_u32(&m, count);
+        for (int j=i; j<i+count; j++) {
+            struct GraphPlus *gp = &leases[exclusions[j]].gp;
+            put_u32(&m, gp->n);
+            for (int k=0; k<gp->n; k++)
+                put_u64(&m, gp->graph[k]);
+        }
+        ok = send_message(w->fd, &m);
+    }
+    free(exclusions);
+    return ok;
+}
+
+static bool send_lease(struct Worker *w, long long lease_id)
+{
+    if (!send_exclusions(w, lease_id))
+        return false;
+    struct GraphPlus *gp = &leases[lease_id].gp;
+    struct Message m;
+    message_init(&m, MSG_LEASE);
+    put_u64(&m, lease_id);
+    put_u32(&m, gp->n);
+    put_u32(&m, gp->edge_count);
+    put_u32(&m, gp->min_deg);
+    put_u32(&m, gp->max_deg);
+    for (int i=0; i<gp->n; i++)
+        put_u64(&m, gp->graph[i]);
+    return send_message(w->fd, &m);
+}
+
+static bool send_empty(struct Worker *w, enum MessageType type)
+{
+    struct Message m;
+    message_init(&m, type);
+    return send_message(w->fd, &m);
+}
+
+static unsigned long long now_ms()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000ull + t.tv_nsec / 1000000;
+}
+
+// Returns true if a worker is idle and there is no lease to give it
+static bool donation_wanted()
+{
+    bool any_idle = false;
+    for (int i=0; i<num_workers; i++)
+        any_idle |= workers[i].idle;
+    return any_idle && find_pending_lease() == -1;
+}
+
+// If a worker is idle and there is nothing to give it, asks the worker that
+// has held its lease longest for a donation.  A worker that had nothing to
+// donate is skipped until DONATION_RETRY_MS have passed.
+static void request_donation()
+{
+    for (int i=0; i<num_workers; i++)
+        if (workers[i].asked)
+            return;
+    if (!donation_wanted())
+        return;
+    unsigned long long now = now_ms();
+    struct Worker *oldest = NULL;
+    for (int i=0; i<num_workers; i++) {
+        struct Worker *w = &workers[i];
+        if (w->exhausted && now - w->exhausted_at >= DONATION_RETRY_MS)
+            w->exhausted = false;
+        if (w->lease != -1 && !w->exhausted && (!oldest || w->lease_stamp < oldest->lease_stamp))
+            oldest = w;
+    }
+    if (oldest && send_empty(oldest, MSG_DONATE_REQUEST))
+        oldest->asked = true;
+}
+
+static void remove_worker(int i)
+{
+    struct Worker *w = &workers[i];
+    if (w->lease != -1 && leases[w->lease].state == LEASE_ACTIVE) {
+        fprintf(stderr, "Worker lost; reissuing lease %lld\n", w->lease);
+        leases[w->lease].state = LEASE_PENDING;
+    }
+    close(w->fd);
+    workers[i] = workers[--num_workers];
+}
+
+// Gives w a lease if there is one.  Returns false if w can't be written to.
+static bool assign_lease(struct Worker *w)
+{
+    long long lease_id = find_pending_lease();
+    if (lease_id == -1) {
+        w->idle = true;
+        return true;
+    }
+    w->idle = false;
+    w->lease = lease_id;
+    w->exhausted = false;
+    w->lease_stamp = lease_stamp++;
+    leases[lease_id].state = LEASE_ACTIVE;
+    leases[lease_id].runs++;
+    return send_lease(w, lease_id);
+}
+
+// Returns false if the message is malformed or unexpected
+static bool handle_message(struct Worker *w, struct Message *m, int min_girth, int n,
+        int edge_count, int *leases_finished)
+{
+    switch (m->type) {
+    case MSG_HELLO: {
+        uint32_t version = get_u32(m);
+        get_u32(m);   // process id
+        if (m->overrun || version != PROTOCOL_VERSION)
+            return false;
+        struct Message reply;
+        message_init(&reply, MSG_SEARCH);
+        put_u32(&reply, min_girth);
+        put_u32(&reply, n);
+        put_u32(&reply, edge_count);
+        put_u32(&reply, global_first_only);
+        return send_message(w->fd, &reply) && assign_lease(w);
+    }
+    case MSG_RESULT: {
+        uint64_t lease_id = get_u64(m);
+        uint64_t graph_count = get_u64(m);
+        uint64_t calls = get_u64(m);
+        uint32_t num_orders = get_u32(m);
+        if (m->overrun || num_orders > MAXN || (long long) lease_id != w->lease)
+            return false;
+        uint64_t visited[MAXN];
+        for (uint32_t i=0; i<num_orders; i++)
+            visited[i] = get_u64(m);
+        char filename[4096];
+        get_string(m, filename, sizeof filename);
+        if (m->overrun)
+            return false;
+
+        for (uint32_t i=0; i<num_orders; i++)
+            num_visited_by_order[i] += visited[i];
+        global_graph_count += graph_count;
+        canonicalisation_calls += calls;
+        if (graph_count)
+            printf("Output file: %s (%llu graphs)\n", filename, (unsigned long long) graph_count);
+        leases[lease_id].state = LEASE_DONE;
+        w->lease = -1;
+        ++*leases_finished;
+
+        // In existence-only mode, no more leases are handed out once a graph
+        // has been found
+        if (global_first_only && global_graph_count) {
+            global_search_stopped = true;
+            for (int i=0; i<num_leases; i++) {
+                if (leases[i].state == LEASE_PENDING) {
+                    leases[i].state = LEASE_CANCELLED;
+                    ++*leases_finished;
+                }
+            }
+        }
+        return assign_lease(w);
+    }
+    case MSG_DONATION: {
+        uint64_t lease_id = get_u64(m);
+        uint32_t count = get_u32(m);
+        w->asked = false;
+        if (count == 0 && (long long) lease_id == w->lease) {
+            w->exhausted = true;
+            w->exhausted_at = now_ms();
+        }
+        if (count && (long long) lease_id != w->lease)
+            return false;
+        for (uint32_t i=0; i<count; i++) {
+            int gp_n = get_u32(m);
+            int gp_edge_count = get_u32(m);
+            int gp_min_deg = get_u32(m);
+            int gp_max_deg = get_u32(m);
+            if (m->overrun || gp_n < 1 || gp_n >= n)
+                return false;
+            graph g[MAXN];
+            EMPTYGRAPH(g, 1, MAXN);
+            for (int j=0; j<gp_n; j++)
+                g[j] = get_u64(m);
+            if (m->overrun)
+                return false;
+            struct GraphPlus gp;
+            make_graph_plus(g, gp_n, gp_edge_count, gp_min_deg, gp_max_deg, &gp);
+            add_lease(&gp);
+            struct Lease *donated = &leases[num_leases-1];
+            donated->donor = lease_id;
+            donated->donor_run = leases[lease_id].runs;
+            donated->num_inherited_exclusions =
+                    find_exclusions(lease_id, &donated->inherited_exclusions);
+            num_donated_leases++;
+            if (global_search_stopped) {
+                leases[num_leases-1].state = LEASE_CANCELLED;
+                ++*leases_finished;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void run_coordinator(char *socket_path, int lease_order, int min_girth, int n, int edge_count)
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = listen_unix_socket(socket_path);
+    if (listen_fd == -1)
+        exit(1);
+
+    global_frontier_order = lease_order;
+    global_frontier_callback = add_lease;
+    find_extremal_graphs(min_girth, n, edge_count);
+    global_frontier_order = 0;
+    printf("Leases: %d graphs of order %d\n", num_leases, lease_order);
+
+    int leases_finished = 0;
+    while (leases_finished < num_leases) {
+        // Idle workers may have work again if a lease has been returned
+        for (int i=0; i<num_workers; i++)
+            if (workers[i].idle && !assign_lease(&workers[i]))
+                remove_worker(i--);
+        request_donation();
+
+        struct pollfd fds[MAX_WORKERS + 1];
+        fds[0] = (struct pollfd) {listen_fd, POLLIN, 0};
+        for (int i=0; i<num_workers; i++)
+            fds[i+1] = (struct pollfd) {workers[i].fd, POLLIN, 0};
+        // While workers are waiting for donations, wake up to ask again
+        int timeout = donation_wanted() ? DONATION_RETRY_MS : -1;
+        if (poll(fds, num_workers + 1, timeout) == -1)
+            continue;   // interrupted by a signal
+
+        // Workers are handled in reverse order so that removing one doesn't
+        // disturb those still to be handled
+        for (int i=num_workers-1; i>=0; i--) {
+            if (!fds[i+1].revents)
+                continue;
+            struct Message m;
+            if (!recv_message(workers[i].fd, &m) ||
+                    !handle_message(&workers[i], &m, min_girth, n, edge_count, &leases_finished))
+                remove_worker(i);
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd != -1) {
+                if (num_workers == MAX_WORKERS)
+                    close(fd);
+                else
+                    workers[num_workers++] = (struct Worker) {fd, -1, false, false, false, 0};
+            }
+        }
+    }
+
+    for (int i=0; i<num_workers; i++) {
+        send_empty(&workers[i], MSG_DONE);
+        close(workers[i].fd);
+    }
+    num_workers = 0;
+    if (num_donated_leases)
+        printf("Leases donated by workers: %d\n", num_donated_leases);
+    close(listen_fd);
+    unlink(socket_path);
+    for (int i=0; i<num_leases; i++)
+        free(leases[i].inherited_exclusions);
+    free(leases);
+}
+
+// The worker's connection to the coordinator, and the lease it is running
+static int coordinator_fd;
+static uint64_t current_lease = UINT64_MAX;
+
+// Returns false if the coordinator can't be written to
+static bool send_donation()
+{
+    struct Message m;
+    message_init(&m, MSG_DONATION);
+    put_u64(&m, current_lease);
+    struct GraphPlus *donated[MAXN * 64];
+    int max_donated = (MAX_MESSAGE_LEN - 12) / (16 + 8 * global_n);
+    if (max_donated > MAXN * 64)
+        max_donated = MAXN * 64;
+    int count = current_lease == UINT64_MAX ? 0 : donate_pending_children(donated, max_donated);
+    put_u32(&m, count);
+    for (int i=0; i<count; i++) {
+        struct GraphPlus *gp = donated[i];
+        put_u32(&m, gp->n);
+        put_u32(&m, gp->edge_count);
+        put_u32(&m, gp->min_deg);
+        put_u32(&m, gp->max_deg);
+        for (int j=0; j<gp->n; j++)
+            put_u64(&m, gp->graph[j]);
+    }
+    return send_message(coordinator_fd, &m);
+}
+
+// Graphs donated from an earlier run of the lease that the worker is about
+// to run, or is running
+struct ExcludedGraph {
+    int n;
+    graph g[MAXN];
+};
+
+static struct ExcludedGraph *excluded = NULL;
+static int num_excluded = 0;
+static int excluded_size = 0;
+
+static void add_exclusions(struct Message *m, int n)
+{
+    uint32_t count = get_u32(m);
+    for (uint32_t i=0; i<count; i++) {
+        if (num_excluded == excluded_size) {
+            excluded_size = excluded_size ? 2 * excluded_size : 64;
+            struct ExcludedGraph *new_excluded = emalloc(excluded_size * sizeof *excluded);
+            if (num_excluded)
+                memcpy(new_excluded, excluded, num_excluded * sizeof *excluded);
+            free(excluded);
+            excluded = new_excluded;
+        }
+        struct ExcludedGraph *e = &excluded[num_excluded++];
+        e->n = get_u32(m);
+        if (m->overrun || e->n < 1 || e->n >= n) {
+            fprintf(stderr, "Bad exclusion list\n");
+            exit(1);
+        }
+        for (int j=0; j<e->n; j++)
+            e->g[j] = get_u64(m);
+    }
+    if (m->overrun) {
+        fprintf(stderr, "Bad exclusion list\n");
+        exit(1);
+    }
+}
+
+// Each excluded graph is found at most once, since the search finds each
+// graph once, so it is removed when it is found
+static bool child_not_excluded(struct GraphPlus *gp)
+{
+    for (int i=0; i<num_excluded; i++) {
+        struct ExcludedGraph *e = &excluded[i];
+        if (e->n == gp->n && !memcmp(e->g, gp->graph, gp->n * sizeof(graph))) {
+            excluded[i] = excluded[--num_excluded];
+            return false;
+        }
+    }
+    return true;
+}
+
+static void request_work_check(int sig)
+{
+    global_work_requested = 1;
+}
+
+// Called from the search when the coordinator's socket has become readable;
+// the only message that the coordinator sends while a lease is running is a
+// donation request
+static void handle_work_request()
+{
+    global_work_requested = 0;
+    struct pollfd pfd = {coordinator_fd, POLLIN, 0};
+    while (poll(&pfd, 1, 0) == 1) {
+        struct Message m;
+        if (!recv_message(coordinator_fd, &m)) {
+            fprintf(stderr, "Lost connection to coordinator\n");
+            exit(1);
+        }
+        if (m.type != MSG_DONATE_REQUEST) {
+            fprintf(stderr, "Unexpected message from coordinator during a lease\n");
+            exit(1);
+        }
+        if (!send_donation()) {
+            fprintf(stderr, "Lost connection to coordinator\n");
+            exit(1);
+        }
+    }
+}
+
+static char *format_extension(enum OutputFormat format)
+{
+    switch (format) {
+    case OUTPUT_GRAPH6:
+        return "g6";
+    case OUTPUT_SPARSE6:
+        return "s6";
+    case OUTPUT_BINARY:
+        return "bin";
+    default:
+        return "out";
+    }
+}
+
+static void run_lease(int fd, struct Message *m, enum OutputFormat format, char *output_dir,
+        int min_girth, int n, int edge_count)
+{
+    uint64_t lease_id = get_u64(m);
+    int gp_n = get_u32(m);
+    int gp_edge_count = get_u32(m);
+    int gp_min_deg = get_u32(m);
+    int gp_max_deg = get_u32(m);
+    if (gp_n < 1 || gp_n >= n) {
+        fprintf(stderr, "Bad lease\n");
+        exit(1);
+    }
+    graph g[MAXN];
+    EMPTYGRAPH(g, 1, MAXN);
+    for (int i=0; i<gp_n; i++)
+        g[i] = get_u64(m);
+    if (m->overrun) {
+        fprintf(stderr, "Bad lease\n");
+        exit(1);
+    }
+    struct GraphPlus gp;
+    make_graph_plus(g, gp_n, gp_edge_count, gp_min_deg, gp_max_deg, &gp);
+
+    char filename[4096], tmp_filename[4200];
+    snprintf(filename, sizeof filename, "%s/lease-%llu.%s", output_dir,
+            (unsigned long long) lease_id, format_extension(format));
+    snprintf(tmp_filename, sizeof tmp_filename, "%s.%d.tmp", filename, (int) getpid());
+    FILE *f = fopen(tmp_filename, "w");
+    if (!f) {
+        fprintf(stderr, "Can't open %s for writing\n", tmp_filename);
+        exit(1);
+    }
+
+    unsigned long long visited_before[MAXN];
+    for (int i=0; i<MAXN; i++)
+        visited_before[i] = num_visited_by_order[i];
+    unsigned long long graph_count_before = global_graph_count;
+    long long calls_before = canonicalisation_calls;
+
+    set_graph_output(format, f, min_girth, n, edge_count, lease_id);
+    current_lease = lease_id;
+    global_child_filter = num_excluded ? child_not_excluded : NULL;
+    search_from(&gp);
+    global_child_filter = NULL;
+    num_excluded = 0;
+    current_lease = UINT64_MAX;
+    close_graph_output();
+    if (rename(tmp_filename, filename) != 0) {
+        fprintf(stderr, "Can't rename %s\n", tmp_filename);
+        exit(1);
+    }
+
+    struct Message result;
+    message_init(&result, MSG_RESULT);
+    put_u64(&result, lease_id);
+    put_u64(&result, global_graph_count - graph_count_before);
+    put_u64(&result, canonicalisation_calls - calls_before);
+    put_u32(&result, n + 1);
+    for (int i=0; i<=n; i++)
+        put_u64(&result, num_visited_by_order[i] - visited_before[i]);
+    put_string(&result, filename);
+    if (!send_message(fd, &result)) {
+        fprintf(stderr, "Lost connection to coordinator\n");
+        exit(1);
+    }
+}
+
+void run_worker(char *socket_path, enum OutputFormat format, char *output_dir)
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    int fd = connect_unix_socket(socket_path, CONNECT_TIMEOUT);
+    if (fd == -1)
+        exit(1);
+    coordinator_fd = fd;
+
+    // SIGIO tells the search to look for a donation request
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = request_work_check;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGIO, &sa, NULL);
+    global_work_request_callback = handle_work_request;
+    fcntl(fd, F_SETOWN, getpid());
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_ASYNC);
+
+    struct Message m;
+    message_init(&m, MSG_HELLO);
+    put_u32(&m, PROTOCOL_VERSION);
+    put_u32(&m, getpid());
+    if (!send_message(fd, &m) || !recv_message(fd, &m) || m.type != MSG_SEARCH) {
+        fprintf(stderr, "Failed to start work from coordinator\n");
+        exit(1);
+    }
+    int min_girth = get_u32(&m);
+    int n = get_u32(&m);
+    int edge_count = get_u32(&m);
+    global_first_only = get_u32(&m);
+    if (m.overrun || n < 2 || n >= MAXN) {
+        fprintf(stderr, "Bad search parameters from coordinator\n");
+        exit(1);
+    }
+    start_search(min_girth, n, edge_count);
+    start_progress(0, NULL, n, num_visited_by_order, &global_graph_count, &canonicalisation_calls);
+
+    int leases_run = 0;
+    while (true) {
+        if (!recv_message(fd, &m)) {
+            fprintf(stderr, "Lost connection to coordinator\n");
+            exit(1);
+        }
+        if (m.type == MSG_DONE)
+            break;
+        if (m.type == MSG_DONATE_REQUEST) {
+            // The request crossed with the result of the last lease.  The
+            // coordinator may have finished since, in which case a DONE
+            // message is waiting.
+            send_donation();
+            continue;
+        }
+        if (m.type == MSG_EXCLUDE) {
+            add_exclusions(&m, n);
+            continue;
+        }
+        if (m.type != MSG_LEASE) {
+            fprintf(stderr, "Unexpected message from coordinator\n");
+            exit(1);
+        }
+        run_lease(fd, &m, format, output_dir, min_girth, n, edge_count);
+        leases_run++;
+    }
+    close(fd);
+    printf("Worker ran %d leases; %llu graphs found\n", leases_run, global_graph_count);
+}
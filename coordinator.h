@@ -0,0 +1,21 @@
+// A coordinator that runs the top of the search tree itself, down to the
+// graphs of order lease_order, and leases the subtrees below those graphs
+// to worker processes that connect to it on a Unix domain socket (see
+// protocol.h for the messages).  A lease held by a worker whose connection
+// closes before it reports a result is given to another worker.
+//
+// When a worker is idle and there are no leases left to hand out, the
+// coordinator asks the worker that has held its lease longest to donate
+// some of the graphs that it has found but not yet visited (see
+// donate_pending_children), and leases them separately.
+//
+// The counts reported by the workers are added to num_visited_by_order,
+// global_graph_count and canonicalisation_calls, so that on return they
+// describe the whole search.
+void run_coordinator(char *socket_path, int lease_order, int min_girth, int n, int edge_count);
+
+// Connects to the coordinator at socket_path and runs the leases it hands
+// out until it has no more.  The graphs found in lease k are written in the
+// given format to output_dir/lease-k.EXT, which only appears once the lease
+// is complete.
+void run_worker(char *socket_path, enum OutputFormat format, char *output_dir);
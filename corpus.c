@@ -0,0 +1,138 @@
+#include "graph_plus.h"
+#include "corpus.h"
+#include "util.h"
+
+#include <string.h>
+
+static int corpus_capacity;
+static int corpus_num_levels;
+
+// One bucket per (order, tentativeness level)
+struct CorpusBucket {
+    unsigned long long seen;
+    struct CorpusRecord *records;   // allocated when first needed
+};
+
+static struct CorpusBucket *buckets = NULL;
+
+// A fixed seed, so that a search captures the same corpus each time
+static uint64_t rng_state = 0x9E3779B97F4A7C15ull;
+
+// xorshift64*
+static uint64_t next_random()
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1Dull;
+}
+
+// The slot in which to keep the item with index seen (counting from 0) of a
+// reservoir of the given capacity, or -1 if it isn't to be kept
+static long long reservoir_slot(unsigned long long seen, int capacity)
+{
+    if (seen < (unsigned long long) capacity)
+        return seen;
+    unsigned long long k = next_random() % (seen + 1);
+    return k < (unsigned long long) capacity ? (long long) k : -1;
+}
+
+void corpus_start(int capacity, int max_tentativeness_level)
+{
+    corpus_capacity = capacity;
+    corpus_num_levels = max_tentativeness_level + 1;
+    buckets = ecalloc((MAXN+1) * corpus_num_levels, sizeof *buckets);
+}
+
+void corpus_begin_graph(struct CorpusRecord *r, struct GraphPlus *gp, int tentativeness_level)
+{
+    memset(r, 0, sizeof *r);
+    r->n = gp->n;
+    r->tentativeness_level = tentativeness_level;
+    r->min_deg = gp->min_deg;
+    r->max_deg = gp->max_deg;
+    r->edge_count = gp->edge_count;
+    for (int i=0; i<gp->n; i++)
+        r->graph[i] = gp->graph[i];
+}
+
+void corpus_add_candidate(struct CorpusRecord *r, setword neighbours)
+{
+    long long slot = reservoir_slot(r->candidates_seen++, CORPUS_MAX_CANDIDATES);
+    if (slot == -1)
+        return;
+    r->candidates[slot] = neighbours;
+    if (slot == r->num_candidates)
+        r->num_candidates++;
+}
+
+void corpus_add_graph(struct CorpusRecord *r)
+{
+    struct CorpusBucket *b = &buckets[r->n * corpus_num_levels + r->tentativeness_level];
+    long long slot = reservoir_slot(b->seen++, corpus_capacity);
+    if (slot == -1)
+        return;
+    if (!b->records)
+        b->records = emalloc(corpus_capacity * sizeof *b->records);
+    b->records[slot] = *r;
+}
+
+void corpus_write(char *filename, int min_girth, int n, int edge_count)
+{
+    FILE *f = fopen(filename, "w");
+    if (!f) {
+        fprintf(stderr, "Can't open %s for writing\n", filename);
+        exit(1);
+    }
+    struct CorpusHeader h = {
+        .version = CORPUS_VERSION,
+        .min_girth = min_girth,
+        .n = n,
+        .edge_count = edge_count,
+        .record_count = 0
+    };
+    memcpy(h.magic, CORPUS_MAGIC, sizeof h.magic);
+    for (int i=0; i<(MAXN+1) * corpus_num_levels; i++) {
+        unsigned long long seen = buckets[i].seen;
+        h.record_count += seen < (unsigned long long) corpus_capacity ? seen : corpus_capacity;
+    }
+
+    bool ok = fwrite(&h, sizeof h, 1, f) == 1;
+    for (int i=0; i<(MAXN+1) * corpus_num_levels; i++) {
+        struct CorpusBucket *b = &buckets[i];
+        unsigned long long count = b->seen < (unsigned long long) corpus_capacity ? b->seen : corpus_capacity;
+        if (count)
+            ok &= fwrite(b->records, sizeof *b->records, count, f) == count;
+        free(b->records);
+    }
+    free(buckets);
+    buckets = NULL;
+    if (fclose(f) != 0 || !ok) {
+        fprintf(stderr, "Failed to write %s\n", filename);
+        exit(1);
+    }
+}
+
+bool corpus_read(char *filename, struct CorpusHeader *h, struct CorpusRecord **records)
+{
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        fprintf(stderr, "Can't open %s\n", filename);
+        return false;
+    }
+    if (fread(h, sizeof *h, 1, f) != 1 || memcmp(h->magic, CORPUS_MAGIC, sizeof h->magic) ||
+            h->version != CORPUS_VERSION) {
+        fprintf(stderr, "%s is not a valid corpus\n", filename);
+        fclose(f);
+        return false;
+    }
+    *records = emalloc((h->record_count ? h->record_count : 1) * sizeof **records);
+    if (fread(*records, sizeof **records, h->record_count, f) != h->record_count) {
+        fprintf(stderr, "%s is truncated\n", filename);
+        free(*records);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,56 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+// A corpus of graphs sampled from a search, for benchmarking kernels on
+// realistic inputs.  For each order and tentativeness level, up to a fixed
+// number of the graphs that were searched are kept by reservoir sampling,
+// and for each of these, up to CORPUS_MAX_CANDIDATES of the neighbour sets
+// for a new vertex that were passed to the canonical deletion test.
+//
+// The file is a struct CorpusHeader followed by record_count struct
+// CorpusRecord, in native byte order.
+
+#define CORPUS_MAGIC "ECDCORPS"
+#define CORPUS_VERSION 1
+
+#define CORPUS_MAX_CANDIDATES 8
+
+struct CorpusHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t min_girth;
+    uint32_t n;                 // the order of the graphs being searched for
+    uint32_t edge_count;
+    uint64_t record_count;
+};
+
+struct CorpusRecord {
+    uint8_t n;
+    uint8_t tentativeness_level;
+    uint8_t min_deg;
+    uint8_t max_deg;
+    uint16_t edge_count;
+    uint8_t num_candidates;
+    uint8_t padding;
+    uint32_t candidates_seen;   // the number of candidates sampled from
+    uint32_t padding2;
+    uint64_t candidates[CORPUS_MAX_CANDIDATES];
+    uint64_t graph[MAXN];
+};
+
+// Keeps up to capacity graphs for each order and tentativeness level
+void corpus_start(int capacity, int max_tentativeness_level);
+
+void corpus_begin_graph(struct CorpusRecord *r, struct GraphPlus *gp, int tentativeness_level);
+
+void corpus_add_candidate(struct CorpusRecord *r, setword neighbours);
+
+// Offers r, with its candidates, to the sample
+void corpus_add_graph(struct CorpusRecord *r);
+
+void corpus_write(char *filename, int min_girth, int n, int edge_count);
+
+// Reads a whole corpus into a newly allocated array.  Returns false, having
+// printed a message to stderr, if the file can't be read or isn't a valid
+// corpus
+bool corpus_read(char *filename, struct CorpusHeader *h, struct CorpusRecord **records);
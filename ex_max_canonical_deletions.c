@@ -2,15 +2,36 @@
 #include "util.h"
 #include "graph_util.h"
 #include "possible_graph_types.h"
+#include "graph_output.h"
+#include "instrument.h"
+#include "progress.h"
+#include "canonical_deletion.h"
+#include "corpus.h"
+#include "search.h"
+#include "coordinator.h"
+#include "frontier.h"
+#include "subtree_costs.h"
+#include "lookahead.h"
 
 #include <stdbool.h>
 #include <limits.h>
+#include <getopt.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <time.h>
 
-#define MAX_TENTATIVENESS_LEVEL 3
+#define DEFAULT_CORPUS_SIZE 256
 
-static int MIN_GIRTH;
+#define DEFAULT_LEASE_ORDER 12
+
+#define DEFAULT_SUBTREE_ORDER 12
+#define DEFAULT_UNEXPLORED_FILENAME "unexplored.frontier"
 
-static long long canonicalisation_calls = 0;
+#if defined(INSTRUMENT) && MAX_LOOKAHEAD_DEPTH >= INSTR_NUM_LEVELS
+#error "INSTR_NUM_LEVELS is too small"
+#endif
+
+static int MIN_GIRTH;
 
 int global_n;
 int global_low_splitting_level = 0;
@@ -19,152 +40,67 @@ int global_split_number = 0;
 
 unsigned long long global_graph_count = 0;
 
-unsigned long long num_visited_by_order[MAXN] = {};
-
-void delete_neighbourhood(int v, graph *g)
-{
-    while (g[v]) {
-        int nb;
-        TAKEBIT(nb, g[v]);
-        DELELEMENT(&g[nb], v);
-    }
-}
+// In existence-only mode, the search stops at the first graph of order global_n
+bool global_first_only = false;
+bool global_search_stopped = false;
 
-bool deletion_is_better(int v, graph *g, int n, int min_deg, int max_deg, int tentativeness_level)
-{
-    graph g0[MAXN], g1[MAXN];
-    for (int i=0; i<n; i++) {
-        g0[i] = g[i];
-        g1[i] = g[i];
-    }
-    // In g0, we delete vertex n-1 and its edges, and don't relabel vertices
-    // In g1, we delete vertex v and its edges, and relabel vertex n-1 to v
-    delete_neighbourhood(n-1, g0);
-    delete_neighbourhood(n-1, g1);
-    delete_neighbourhood(v, g1);
-    setword neighbours = g[n-1];
-    while (neighbours) {
-        int nb;
-        TAKEBIT(nb, neighbours);
-        if (nb != v) {
-            ADDONEEDGE(g1, v, nb, 1);
-        }
-    }
-
-    setword sw0a = 0;
-    setword sw1a = 0;
-    for (int deg=min_deg; deg<=max_deg; deg++) {
-        setword sw0 = 0;
-        setword sw1 = 0;
-        for (int i=0; i<n; i++) {
-            if (POPCOUNT(g0[i]) == deg) {
-                sw0 ^= g0[i];
-                sw0a ^= g0[i];
-            }
-            if (POPCOUNT(g1[i]) == deg) {
-                sw1 ^= g1[i];
-                sw1a ^= g1[i];
-            }
-        }
-        int pc0 = POPCOUNT(sw0);
-        int pc1 = POPCOUNT(sw1);
-        if (pc0 < pc1)
-            return true;
-        if (pc0 > pc1)
-            return false;
-        pc0 = POPCOUNT(sw0a);
-        pc1 = POPCOUNT(sw1a);
-        if (pc0 < pc1)
-            return true;
-        if (pc0 > pc1)
-            return false;
-    }
-
-    if (tentativeness_level != 0)
-        return false;
-
-    graph g1_canon[MAXN];
-    make_canonical(g1, n-1, g1_canon);
-    canonicalisation_calls++;
-
-    return compare_graphs(g0, g1_canon, n-1) == GREATER_THAN;
-}
+unsigned long long num_visited_by_order[MAXN] = {};
 
-int modified_nb_deg_sum(graph *g, int v, setword s) {
-    int deg_sum = 0;
-    setword nb = g[v];
-    while (nb) {
-        int w;
-        TAKEBIT(w, nb);
-        deg_sum += POPCOUNT(g[w] & s);
-    }
-    return deg_sum;
-}
+// If set, a sample of the graphs searched is written to this file (see corpus.h)
+char *global_corpus_filename = NULL;
 
-// For correctness, we have to be really careful about what rules we
-// put in here.
-// Assumption: the last vertex of g has degree equal to min_deg
-bool deletion_is_canonical(graph *g, int n, int min_deg, int max_deg,
-        int tentativeness_level, setword vertices_of_min_deg)
-{
-    int n0 = POPCOUNT(g[n-1] & vertices_of_min_deg);
-    int nds0mod = modified_nb_deg_sum(g, n-1, vertices_of_min_deg);
-    int nds0 = nb_deg_sum_self_contained(g, n-1);
+int global_frontier_order = 0;
+void (*global_frontier_callback)(struct GraphPlus *gp) = NULL;
 
-    setword vertices_to_check_deletion = 0;
+volatile sig_atomic_t global_work_requested = 0;
+void (*global_work_request_callback)() = NULL;
+bool (*global_child_filter)(struct GraphPlus *gp) = NULL;
 
-    setword vv = vertices_of_min_deg ^ bit[n-1];
-    while (vv) {
-        int i;
-        TAKEBIT(i, vv);
+setword global_allowed_degrees = ~(setword) 0;
+int global_regular_degree = 0;
+bool global_bipartite = false;
 
-        int n1 = POPCOUNT(g[i] & vertices_of_min_deg);
-        if (n1 > n0)
-            return false;
-        else if (n1 != n0)
-            continue;
-
-        int nds1mod = modified_nb_deg_sum(g, i, vertices_of_min_deg);
-        if (nds1mod < nds0mod)
-            return false;
-        else if (nds1mod != nds0mod)
-            continue;
+ExtremalPredicate global_predicate = NULL;
+const char *global_predicate_arg = NULL;
+bool global_predicate_is_hereditary = false;
 
-        int nds1 = nb_deg_sum_self_contained(g, i);
-        if (nds1 < nds0)
-            return false;
-        else if (nds1 == nds0)
-            vertices_to_check_deletion |= bit[i];
-    }
+// The neighbour sets of a new vertex that, when the lookahead from a
+// graph's parent visited the graph at tentativeness level 1, gave graphs
+// that failed their visits at level 2.  A graph that fails at level 2
+// fails at level 1, so the visit to the graph at level 0 can skip them.
+// The lookahead stops at the first extension that succeeds, so this only
+// covers the extensions tried before it, up to LOOKAHEAD_MEMO_SIZE of them.
+#define LOOKAHEAD_MEMO_SIZE 4
 
-    if (!vertices_to_check_deletion)
-        return true;
+struct LookaheadMemo {
+    int count;
+    setword failed[LOOKAHEAD_MEMO_SIZE];
+};
 
-    unsigned long long nnds0 = weighted_nb_nb_deg_sum(g, n-1);
-    setword tmp = vertices_to_check_deletion;
-    vertices_to_check_deletion = 0;
-    while (tmp) {
-        int v;
-        TAKEBIT(v, tmp);
-        unsigned long long nnds1 = weighted_nb_nb_deg_sum(g, v);
-        if (nnds1 < nnds0) {
-            return false;
-        } else if (nnds1 == nnds0) {
-            // Delay the expensive checks that use Nauty;
-            // if we're lucky, we won't need to do them at all.
-            vertices_to_check_deletion |= bit[v];
-        }
-    }
+// A child found by a visit at tentativeness level 0, to be visited once the
+// search for children is complete
+struct Child {
+    struct GraphPlus *gp;                  // in the parent's gp_set
+    struct LookaheadMemo memo;             // in gp's labelling
+    bool has_short_path_arr;
+    setword have_short_path[MAXN];
+};
 
-    while (vertices_to_check_deletion) {
-        int v;
-        TAKEBIT(v, vertices_to_check_deletion);
-        if (deletion_is_better(v, g, n, min_deg, max_deg, tentativeness_level))
-            return false;
-    }
+// The graph of each order on the current path at tentativeness level 0,
+// and its children.  The children from next to count-1 have not been
+// visited yet, and may be given away by donate_pending_children.  The
+// search keeps its path here rather than on the C stack, so that it can be
+// suspended between graphs (see struct SearchIter).
+struct Frame {
+    struct GraphPlus *gp;
+    struct GraphPlusSet gp_set;   // the children, without duplicates
+    struct Child *children;
+    int next;
+    int count;
+    int size;
+};
 
-    return true;
-}
+static struct Frame frames[MAXN];
 
 struct SearchData
 {
@@ -175,14 +111,89 @@ struct SearchData
     int tentativeness_level;
     setword vertices_of_min_deg;
     setword vertices_of_min_deg_plus1;
+    struct CorpusRecord *corpus_record;   // NULL unless capturing a corpus
+    struct Frame *frame;                  // at tentativeness level 0
+    setword *opposite_colour;             // NULL unless in bipartite mode
+    struct LookaheadMemo *memo;           // see visit_graph; may be NULL
 };
 
-bool visit_graph(struct GraphPlus *gp, int tentativeness_level, graph *parent_have_short_path);
+static struct Child *add_child(struct Frame *p, struct GraphPlus *gp)
+{
+    if (p->count == p->size) {
+        p->size = p->size ? 2 * p->size : 16;
+        struct Child *children = emalloc(p->size * sizeof *children);
+        for (int i=0; i<p->count; i++)
+            children[i] = p->children[i];
+        free(p->children);
+        p->children = children;
+    }
+    struct Child *c = &p->children[p->count++];
+    c->gp = gp;
+    c->memo.count = 0;
+    c->has_short_path_arr = false;
+    return c;
+}
+
+int donate_pending_children(struct GraphPlus **donated, int max_donated)
+{
+    // Children of order global_n are leaves, and not worth giving away
+    for (int order=1; order<global_n-1; order++) {
+        struct Frame *p = &frames[order];
+        int num_pending = p->count - p->next;
+        if (num_pending <= 0)
+            continue;
+        // Keep the left half, rounding down, so that a single pending
+        // child is given away
+        int num_donated = num_pending - num_pending / 2;
+        if (num_donated > max_donated)
+            num_donated = max_donated;
+        p->count -= num_donated;
+        progress_set_children(order, p->count);
+        for (int i=0; i<num_donated; i++)
+            donated[i] = p->children[p->count + i].gp;
+        return num_donated;
+    }
+    return 0;
+}
+
+bool visit_graph(struct GraphPlus *gp, int tentativeness_level, graph *short_path_arr,
+        struct LookaheadMemo *memo);
+
+static bool memo_contains(struct LookaheadMemo *memo, setword neighbours)
+{
+    for (int i=0; i<memo->count; i++)
+        if (memo->failed[i] == neighbours)
+            return true;
+    return false;
+}
+
+// Relabels the neighbour sets of memo by lab, as from make_canonical
+static void relabel_memo(struct LookaheadMemo *memo, int n, int *lab,
+        struct LookaheadMemo *relabelled_memo)
+{
+    relabelled_memo->count = memo->count;
+    for (int k=0; k<memo->count; k++) {
+        setword s = 0;
+        for (int i=0; i<n; i++)
+            if (memo->failed[k] & bit[lab[i]])
+                s |= bit[i];
+        relabelled_memo->failed[k] = s;
+    }
+}
 
 // sd->gp is the graph that we're augmenting
 bool output_graph(struct SearchData *sd, setword neighbours, bool max_deg_incremented)
 {
     int n = sd->gp->n + 1;
+    INSTR_SCOPE(PHASE_OUTPUT_GRAPH, n);
+
+    if (sd->corpus_record)
+        corpus_add_candidate(sd->corpus_record, neighbours);
+
+    if (sd->tentativeness_level == 0 && sd->memo && memo_contains(sd->memo, neighbours)) {
+        INSTR_COUNT(COUNTER_LOOKAHEAD_MEMO_HIT, n);
+        return false;
+    }
 
     graph new_g[MAXN];
     for (int i=0; i<MAXN; i++)
@@ -214,17 +225,55 @@ bool output_graph(struct SearchData *sd, setword neighbours, bool max_deg_increm
     struct GraphPlus tentative_gp;
     int edge_count = sd->gp->edge_count + min_deg;
     make_graph_plus(new_g, n, edge_count, min_deg, max_deg, &tentative_gp);
-    if (!visit_graph(&tentative_gp, sd->tentativeness_level + 1, sd->have_short_path))
+    struct LookaheadMemo memo = {0};
+    if (sd->tentativeness_level == 0) {
+        if (lookahead_depth[n]) {
+            unsigned long long work = lookahead_work;
+            bool passed = visit_graph(&tentative_gp, 1, sd->have_short_path, &memo);
+            if (lookahead_is_adaptive)
+                lookahead_record(n, !passed, lookahead_work - work);
+            if (!passed)
+                return false;
+        }
+    } else if (!visit_graph(&tentative_gp, sd->tentativeness_level + 1, sd->have_short_path, NULL)) {
+        if (sd->tentativeness_level == 1 && sd->memo && sd->memo->count < LOOKAHEAD_MEMO_SIZE)
+            sd->memo->failed[sd->memo->count++] = neighbours;
         return false;
+    }
 
     if (sd->tentativeness_level == 0) {
         graph new_g_canonical[MAXN];
-        make_canonical(new_g, n, new_g_canonical);
+        int lab[MAXN];
+        INSTR_ENTER(PHASE_CANON_OUTPUT, n);
+        make_canonical(new_g, n, new_g_canonical, lab);
+        INSTR_LEAVE();
         canonicalisation_calls++;
+        INSTR_ENTER(PHASE_GP_SET_ADD, n);
         struct GraphPlus *canonicalised_gp = gp_set_add(
                 sd->gp_set, new_g_canonical, n, edge_count, min_deg, max_deg);
-        if (canonicalised_gp)   // if not already in set
-            visit_graph(canonicalised_gp, 0, NULL);
+        INSTR_LEAVE();
+        INSTR_COUNT(canonicalised_gp ? COUNTER_GP_SET_NEW : COUNTER_GP_SET_DUPLICATE, n);
+        if (canonicalised_gp && global_child_filter && !global_child_filter(canonicalised_gp))
+            canonicalised_gp = NULL;
+        if (canonicalised_gp) {   // if not already in set
+            if (n == global_frontier_order) {
+                global_frontier_callback(canonicalised_gp);
+            } else {
+                struct Child *c = add_child(sd->frame, canonicalised_gp);
+                // Extend the parent's short path array by the new vertex, and
+                // carry it through the canonical relabelling, rather than
+                // recomputing it from scratch in visit_graph
+                if (n < global_n) {
+                    relabel_memo(&memo, n, lab, &c->memo);
+                    setword new_have_short_path[MAXN];
+                    INSTR_ENTER(PHASE_SHORT_PATH_EXTEND, n);
+                    extend_short_path_arr(new_g, n, MIN_GIRTH-3, new_have_short_path, sd->have_short_path);
+                    relabel_short_path_arr(new_have_short_path, n, lab, c->have_short_path);
+                    INSTR_LEAVE();
+                    c->has_short_path_arr = true;
+                }
+            }
+        }
     }
     return true;
 }
@@ -253,10 +302,14 @@ bool search(struct SearchData *sd, setword neighbours, setword candidate_neighbo
 
     if (candidate_neighbours && neighbours_count <= sd->gp->min_deg) {
         do {
+            if (global_search_stopped)
+                return false;
             int cand;
             TAKEBIT(cand, candidate_neighbours);
             setword new_neighbours = neighbours | bit[cand];
             setword new_candidates = candidate_neighbours & ~sd->have_short_path[cand];
+            if (sd->opposite_colour)
+                new_candidates &= ~sd->opposite_colour[cand];
             if (search(sd, new_neighbours, new_candidates,
                     max_deg_incremented || POPCOUNT(sd->gp->graph[cand]) == sd->gp->max_deg) &&
                     sd->tentativeness_level)
@@ -266,36 +319,82 @@ bool search(struct SearchData *sd, setword neighbours, setword candidate_neighbo
     return false;
 }
 
-// add a vertex to the graph
-bool visit_graph(struct GraphPlus *gp, int tentativeness_level, graph *parent_have_short_path)
+// In regular mode, can gp be extended to a k-regular graph of order global_n?
+// Each vertex v of gp has a deficit of k - deg(v) edges to the vertices yet
+// to be added, of which there are r.  A vertex yet to be added has at most
+// k neighbours in gp, and can't be joined to two vertices within
+// (MIN_GIRTH-3)/2 of the same vertex of gp, as that would make a cycle of
+// length less than MIN_GIRTH; so the deficits in each such ball sum to at
+// most r.
+static bool regular_completion_is_feasible(struct GraphPlus *gp)
 {
-    if (!tentativeness_level) {
-        num_visited_by_order[gp->n]++;
-
-        if (gp->n==global_n) {
-            // output graph
-            global_graph_count++;
-            show_graph(gp);
-            return true;        // return value of non-tentative version is unused
+    int k = global_regular_degree;
+    int r = global_n - gp->n;
+    int radius = (MIN_GIRTH - 3) / 2;
+    int deficit[MAXN];
+    int total_deficit = 0;
+    setword deficient = 0;
+    for (int i=0; i<gp->n; i++) {
+        deficit[i] = k - POPCOUNT(gp->graph[i]);
+        if (deficit[i] > r)
+            return false;
+        if (deficit[i]) {
+            total_deficit += deficit[i];
+            deficient |= bit[i];
         }
+    }
+    if (total_deficit > k * r)
+        return false;
 
-        if (global_n > global_high_splitting_level &&
-                gp->n >= global_low_splitting_level &&
-                gp->n <= global_high_splitting_level) {
-            bool bit = (num_visited_by_order[gp->n] & 1ull) != 0;
-            if ((((unsigned) global_split_number >> (gp->n - global_low_splitting_level)) & 1) == bit)
-                return true;
+    for (int v=0; v<gp->n; v++) {
+        setword ball = bit[v];
+        for (int d=0; d<radius; d++) {
+            setword b = ball;
+            while (b) {
+                int w;
+                TAKEBIT(w, b);
+                ball |= gp->graph[w];
+            }
         }
-    } else if (gp->n == global_n) {
-        return true;
+        int ball_deficit = 0;
+        setword b = ball & deficient;
+        while (b) {
+            int w;
+            TAKEBIT(w, b);
+            ball_deficit += deficit[w];
+        }
+        if (ball_deficit > r)
+            return false;
     }
+    return true;
+}
 
-    struct GraphPlusSet gp_set;
-    struct GraphPlusSet *gp_set_ptr = NULL;
-    if (!tentativeness_level) {
-        gp_set = make_gp_set();
-        gp_set_ptr = &gp_set;
-    }
+// add a vertex to the graph
+// short_path_arr: at tentativeness level 0, either gp's own short path array
+//                 or NULL if it must be computed from scratch; at other
+//                 levels, the short path array of gp's parent
+// memo:           at tentativeness level 0, the extensions of gp known to
+//                 fail, or NULL; at level 1, where to record the extensions
+//                 that fail, or NULL (see struct LookaheadMemo)
+bool visit_graph(struct GraphPlus *gp, int tentativeness_level, graph *short_path_arr,
+        struct LookaheadMemo *memo)
+{
+    INSTR_SCOPE(tentativeness_level ? PHASE_TENTATIVE_VISIT : PHASE_VISIT, gp->n);
+
+    if (tentativeness_level && gp->n == global_n)
+        return true;
+
+    if (tentativeness_level)
+        lookahead_work++;
+
+    if (global_regular_degree && !regular_completion_is_feasible(gp))
+        return false;
+
+    // In bipartite mode, the new vertex's neighbours in each component of gp
+    // must all have the same colour
+    setword opposite_colour[MAXN];
+    if (global_bipartite && !opposite_colour_arr(gp->graph, gp->n, opposite_colour))
+        return false;
 
     setword min_degs[2];
     for (int i=0; i<2; i++) {
@@ -325,17 +424,39 @@ bool visit_graph(struct GraphPlus *gp, int tentativeness_level, graph *parent_ha
     if (min_degs[1] == 0)
         candidate_neighbours &= ~vertices_of_max_deg;
 
+    // In the last step, the new vertex must be joined to each vertex whose
+    // degree isn't allowed, and not to any whose degree plus one isn't
+    if (gp->n == global_n - 1 && ~global_allowed_degrees) {
+        for (int i=gp->min_deg; i<=gp->max_deg; i++) {
+            if (!(global_allowed_degrees & bit[i]))
+                forced_neighbours |= vertices_of_deg[i];
+            if (i+1 >= MAXN || !(global_allowed_degrees & bit[i+1]))
+                candidate_neighbours &= ~vertices_of_deg[i];
+        }
+        if (forced_neighbours & ~candidate_neighbours)
+            return false;
+    }
+
     if (POPCOUNT(forced_neighbours) > gp->min_deg + 1)
         return false;
 
-    if (tentativeness_level == MAX_TENTATIVENESS_LEVEL || (tentativeness_level != 0 && gp->n == global_n))
+    // The lookahead started from a child of order gp->n - tentativeness_level + 1
+    if (tentativeness_level != 0 &&
+            (tentativeness_level == lookahead_depth[gp->n - tentativeness_level + 1] || gp->n == global_n))
         return true;
 
     setword have_short_path[MAXN];
-    if (!tentativeness_level) {
-        all_pairs_check_for_short_path(gp->graph, gp->n, MIN_GIRTH-3, have_short_path);
+    if (tentativeness_level) {
+        INSTR_ENTER(PHASE_SHORT_PATH_EXTEND, gp->n);
+        extend_short_path_arr(gp->graph, gp->n, MIN_GIRTH-3, have_short_path, short_path_arr);
+        INSTR_LEAVE();
+    } else if (short_path_arr) {
+        for (int i=0; i<gp->n; i++)
+            have_short_path[i] = short_path_arr[i];
     } else {
-        extend_short_path_arr(gp->graph, gp->n, MIN_GIRTH-3, have_short_path, parent_have_short_path);
+        INSTR_ENTER(PHASE_SHORT_PATH_ALL_PAIRS, gp->n);
+        all_pairs_check_for_short_path(gp->graph, gp->n, MIN_GIRTH-3, have_short_path);
+        INSTR_LEAVE();
     }
 
     setword neighbours = 0;
@@ -348,6 +469,8 @@ bool visit_graph(struct GraphPlus *gp, int tentativeness_level, graph *parent_ha
             TAKEBIT(cand, forced_neighbours_copy);
             ADDELEMENT(&neighbours, cand);
             candidate_neighbours &= ~have_short_path[cand];
+            if (global_bipartite)
+                candidate_neighbours &= ~opposite_colour[cand];
             all_forced_neighbours_are_feasible &= 0 == (forced_neighbours & ~(neighbours | candidate_neighbours));
         }
         if (!all_forced_neighbours_are_feasible)
@@ -356,35 +479,673 @@ bool visit_graph(struct GraphPlus *gp, int tentativeness_level, graph *parent_ha
             max_deg_incremented = true;
     }
 
-    struct SearchData sd = {gp, have_short_path, gp_set_ptr, {min_degs[0], min_degs[1]},
-            tentativeness_level, vertices_of_min_deg, vertices_of_min_deg_plus1};
+    struct CorpusRecord corpus_record;
+    struct CorpusRecord *corpus_record_ptr = NULL;
+    if (global_corpus_filename) {
+        corpus_begin_graph(&corpus_record, gp, tentativeness_level);
+        corpus_record_ptr = &corpus_record;
+    }
+
+    struct Frame *frame = NULL;
+    if (!tentativeness_level) {
+        frame = &frames[gp->n];
+        frame->gp = gp;
+        frame->gp_set = make_gp_set();
+        frame->next = 0;
+        frame->count = 0;
+    }
+
+    struct SearchData sd = {gp, have_short_path, frame ? &frame->gp_set : NULL,
+            {min_degs[0], min_degs[1]}, tentativeness_level, vertices_of_min_deg,
+            vertices_of_min_deg_plus1, corpus_record_ptr, frame,
+            global_bipartite ? opposite_colour : NULL, memo};
     bool search_result = search(&sd, neighbours, candidate_neighbours, max_deg_incremented);
-    if (tentativeness_level) {
-        return search_result;
-    } else {
-        free_tree(&gp_set.tree_head);
-        return true;
+    if (corpus_record_ptr)
+        corpus_add_graph(corpus_record_ptr);
+    // At tentativeness level 0, the frame has been filled, and the children
+    // are visited by search_iter_next
+    return tentativeness_level ? search_result : true;
+}
+
+// Is gp, at tentativeness level 0, in a subtree left to another shard?
+static bool in_other_shard(struct GraphPlus *gp)
+{
+    if (global_n > global_high_splitting_level &&
+            gp->n >= global_low_splitting_level &&
+            gp->n <= global_high_splitting_level) {
+        bool bit = (num_visited_by_order[gp->n] & 1ull) != 0;
+        if ((((unsigned) global_split_number >> (gp->n - global_low_splitting_level)) & 1) == bit)
+            return true;
     }
+    return false;
 }
 
-void find_extremal_graphs(int n, int edge_count)
+enum Entered {ENTERED_PRUNED, ENTERED_LEAF, ENTERED_FRAME};
+
+static void leave_graph(struct GraphPlus *gp)
 {
-    if (global_low_splitting_level > 0 && global_split_number != 0 && n <= global_high_splitting_level)
+    if (gp->n == subtree_costs_order)
+        subtree_costs_leave(gp);
+    progress_leave_subtree(gp->n);
+}
+
+// Visits gp at tentativeness level 0.  If its children have been put in
+// frames[gp->n], returns ENTERED_FRAME, and the frame must be left later by
+// leave_frame; otherwise gp has already been left.
+static enum Entered enter_graph(struct GraphPlus *gp, graph *short_path_arr,
+        struct LookaheadMemo *memo)
+{
+    progress_enter_subtree(gp->n);
+    if (gp->n == subtree_costs_order)
+        subtree_costs_enter(gp);
+
+    enum Entered result = ENTERED_PRUNED;
+    if (!global_search_stopped) {
+        if (global_work_requested)
+            global_work_request_callback();
+
+        num_visited_by_order[gp->n]++;
+
+        if (gp->n == global_n) {
+            if (!global_predicate ||
+                    global_predicate((const uint64_t *) gp->graph, gp->n, global_predicate_arg)) {
+                global_graph_count++;
+                if (global_first_only)
+                    global_search_stopped = true;
+                result = ENTERED_LEAF;
+            }
+        } else if (global_predicate_is_hereditary &&
+                !global_predicate((const uint64_t *) gp->graph, gp->n, global_predicate_arg)) {
+            // pruned, along with the subtree
+        } else if (!in_other_shard(gp) && visit_graph(gp, 0, short_path_arr, memo)) {
+            progress_set_children(gp->n, frames[gp->n].count);
+            result = ENTERED_FRAME;
+        }
+    }
+    if (result != ENTERED_FRAME)
+        leave_graph(gp);
+    return result;
+}
+
+static void leave_frame(struct Frame *frame)
+{
+    frame->count = 0;
+    free_tree(&frame->gp_set.tree_head);
+    leave_graph(frame->gp);
+}
+
+static double time_budget = 0;
+static unsigned long long memory_budget = 0;
+static struct timespec budget_start_time;
+static void (*unexplored_callback)(struct GraphPlus *gp);
+const char *global_budget_exhausted = NULL;
+
+void set_budgets(double seconds, unsigned long long bytes,
+        void (*callback)(struct GraphPlus *gp))
+{
+    time_budget = seconds;
+    memory_budget = bytes;
+    unexplored_callback = callback;
+    clock_gettime(CLOCK_MONOTONIC, &budget_start_time);
+}
+
+// The memory held by the frames for the children of the graphs on the path
+// from order low to top
+static unsigned long long frame_memory(int low, int top)
+{
+    unsigned long long bytes = 0;
+    for (int order=0; order<MAXN; order++)
+        bytes += frames[order].size * sizeof(struct Child);
+    for (int order=low; order<=top; order++)
+        bytes += frames[order].gp_set.sz * sizeof(struct GraphPlus);
+    return bytes;
+}
+
+// If a budget has run out, stops the search and hands over the unexplored
+// subtrees of the frames from order low to top
+static void check_budgets(int low, int top)
+{
+    static unsigned checks = 0;
+    if ((!time_budget && !memory_budget) || global_search_stopped || (++checks & 63))
+        return;
+    if (time_budget) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double secs = (now.tv_sec - budget_start_time.tv_sec) +
+                (now.tv_nsec - budget_start_time.tv_nsec) / 1e9;
+        if (secs > time_budget)
+            global_budget_exhausted = "time";
+    }
+    if (memory_budget && frame_memory(low, top) > memory_budget)
+        global_budget_exhausted = "memory";
+    if (!global_budget_exhausted)
         return;
+    global_search_stopped = true;
+    for (int order=low; order<=top; order++) {
+        struct Frame *frame = &frames[order];
+        for (int i=frame->next; i<frame->count; i++)
+            unexplored_callback(frame->children[i].gp);
+        frame->next = frame->count;
+    }
+}
 
-    make_possible_graph_types(n, edge_count, MIN_GIRTH);
+void search_iter_start(struct SearchIter *it, struct GraphPlus *root)
+{
+    it->root = *root;
+    it->started = false;
+    it->top = root->n - 1;
+}
+
+struct GraphPlus *search_iter_next(struct SearchIter *it)
+{
+    if (!it->started) {
+        it->started = true;
+        switch (enter_graph(&it->root, NULL, NULL)) {
+        case ENTERED_LEAF:
+            return &it->root;
+        case ENTERED_FRAME:
+            it->top = it->root.n;
+            break;
+        case ENTERED_PRUNED:
+            break;
+        }
+    }
+    while (it->top >= it->root.n) {
+        check_budgets(it->root.n, it->top);
+        struct Frame *frame = &frames[it->top];
+        // The count may be reduced while the children are being visited, by
+        // donate_pending_children
+        if (frame->next == frame->count || global_search_stopped) {
+            leave_frame(frame);
+            it->top--;
+            continue;
+        }
+        struct Child *c = &frame->children[frame->next++];
+        switch (enter_graph(c->gp, c->has_short_path_arr ? c->have_short_path : NULL, &c->memo)) {
+        case ENTERED_LEAF:
+            return c->gp;
+        case ENTERED_FRAME:
+            it->top++;
+            break;
+        case ENTERED_PRUNED:
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void write_all_graphs(struct SearchIter *it)
+{
+    struct GraphPlus *gp;
+    while ((gp = search_iter_next(it))) {
+        INSTR_ENTER(PHASE_WRITE_GRAPH, gp->n);
+        write_graph(gp);
+        INSTR_LEAVE();
+    }
+}
+
+void start_search(int min_girth, int n, int edge_count)
+{
+    MIN_GIRTH = min_girth;
+    global_n = n;
+    make_possible_graph_types(n, edge_count, MIN_GIRTH, global_allowed_degrees);
+    // With splitting, the graphs visited up to the high splitting level
+    // decide which part each run searches, so the lookahead depths for
+    // those orders must not depend on the run
+    start_lookahead(global_low_splitting_level > 0 ? global_high_splitting_level : 0);
+}
+
+void search_from(struct GraphPlus *gp)
+{
+    struct SearchIter it;
+    search_iter_start(&it, gp);
+    write_all_graphs(&it);
+}
+
+bool search_iter_start_full(struct SearchIter *it, int min_girth, int n, int edge_count)
+{
+    if (global_low_splitting_level > 0 && global_split_number != 0 && n <= global_high_splitting_level)
+        return false;
+
+    start_search(min_girth, n, edge_count);
 
     graph g[MAXN];
     EMPTYGRAPH(g,1,MAXN);
     struct GraphPlus gp;
     make_graph_plus(g, 1, 0, 0, 0, &gp);
-    visit_graph(&gp, 0, NULL);
+    search_iter_start(it, &gp);
+    return true;
+}
+
+void find_extremal_graphs(int min_girth, int n, int edge_count)
+{
+    struct SearchIter it;
+    if (search_iter_start_full(&it, min_girth, n, edge_count))
+        write_all_graphs(&it);
+}
+
+#ifndef EXTREMAL_LIBRARY
+
+static FILE *frontier_file;
+static long long frontier_count = 0;
+
+static void emit_frontier_graph(struct GraphPlus *gp)
+{
+    frontier_write_graph(frontier_file, gp);
+    frontier_count++;
+}
+
+// The unexplored subtrees left when a budget runs out are written to this
+// frontier, of mixed orders
+static char *unexplored_filename = DEFAULT_UNEXPLORED_FILENAME;
+static FILE *unexplored_file = NULL;
+static long long unexplored_count = 0;
+static int unexplored_min_girth, unexplored_n, unexplored_edge_count;
+
+static void open_unexplored_file()
+{
+    if (unexplored_file)
+        return;
+    unexplored_file = fopen(unexplored_filename, "w");
+    if (!unexplored_file) {
+        printf("Can't open %s for writing\n", unexplored_filename);
+        exit(1);
+    }
+    frontier_write_header(unexplored_file, unexplored_min_girth, unexplored_n,
+            unexplored_edge_count, 0);
+}
+
+static void write_unexplored_graph(struct GraphPlus *gp)
+{
+    open_unexplored_file();
+    frontier_write_mixed_graph(unexplored_file, gp);
+    unexplored_count++;
+}
+
+// Searches the subtrees below the graphs of a frontier (or of the slice of
+// it that was read)
+static void search_frontier(struct Frontier *fr, int edge_count)
+{
+    start_search(MIN_GIRTH, fr->n, edge_count);
+    progress_set_roots(fr->num_graphs);
+    long long i;
+    for (i=0; i<fr->num_graphs && !global_search_stopped; i++)
+        search_from(&fr->graphs[i]);
+    if (global_budget_exhausted)
+        for (; i<fr->num_graphs; i++)
+            write_unexplored_graph(&fr->graphs[i]);
+}
+
+// Sets global_predicate from --predicate=NAME[:ARG], where NAME is a built-in
+// predicate, or a function in library_filename if that is not NULL
+static void set_predicate(char *spec, char *library_filename, bool is_hereditary)
+{
+    char *colon = strchr(spec, ':');
+    if (colon) {
+        *colon = '\0';
+        global_predicate_arg = colon + 1;
+    }
+    if (library_filename) {
+        void *library = dlopen(library_filename, RTLD_NOW);
+        if (!library) {
+            printf("Can't load %s: %s\n", library_filename, dlerror());
+            exit(1);
+        }
+        global_predicate = (ExtremalPredicate) dlsym(library, spec);
+        if (!global_predicate) {
+            printf("%s has no predicate %s\n", library_filename, spec);
+            exit(1);
+        }
+        global_predicate_is_hereditary = is_hereditary;
+    } else {
+        if (!extremal_builtin_predicate(spec, &global_predicate, &global_predicate_is_hereditary)) {
+            printf("Unknown predicate %s\n", spec);
+            exit(1);
+        }
+        if (is_hereditary) {
+            printf("--hereditary only applies to predicates from --predicate-lib\n");
+            exit(1);
+        }
+    }
+}
+
+// Parses a comma-separated list of degrees into a setword, or returns 0 if
+// the list is malformed
+static setword parse_degree_set(const char *s)
+{
+    setword degrees = 0;
+    for (;;) {
+        char *end;
+        long d = strtol(s, &end, 10);
+        if (end == s || d < 0 || d >= MAXN)
+            return 0;
+        degrees |= bit[d];
+        if (*end == '\0')
+            return degrees;
+        if (*end != ',')
+            return 0;
+        s = end + 1;
+    }
+}
+
+static void print_usage()
+{
+    printf("Usage: ex_max_canonical_deletions [options] min_girth n edge_count\n");
+    printf("           [low_splitting_level high_splitting_level split_number]\n");
+    printf("Options:\n");
+    printf("  -f, --format=FORMAT   write graphs as matrix (default), graph6, sparse6\n");
+    printf("                        or binary (see graph_container.h)\n");
+    printf("  -o, --output=FILE     write graphs to FILE instead of stdout\n");
+    printf("      --first           stop as soon as one graph has been found\n");
+    printf("      --progress=SECONDS  report progress every SECONDS seconds\n");
+    printf("      --status-file=FILE  write progress reports to FILE instead of stderr\n");
+    printf("      --capture-corpus=FILE  write a sample of the graphs searched to FILE,\n");
+    printf("                        for replay_corpus\n");
+    printf("      --corpus-size=K   sample up to K graphs per order and tentativeness\n");
+    printf("                        level (default %d)\n", DEFAULT_CORPUS_SIZE);
+    printf("      --summary=FILE    if any graphs are found, append a line\n");
+    printf("                        \"min_girth n edge_count graph_count\" to FILE\n");
+    printf("      --subtree-costs=FILE  write the nodes, canonicalisation calls, graphs\n");
+    printf("                        and time of the subtree below each graph of the\n");
+    printf("                        subtree order to FILE (see subtree_costs.h)\n");
+    printf("      --subtree-order=K the order for --subtree-costs (default %d)\n", DEFAULT_SUBTREE_ORDER);
+    printf("      --predicate=NAME[:ARG]  only find graphs that satisfy a predicate:\n");
+    printf("                        bipartite, connected, max-diameter:D,\n");
+    printf("                        degrees:D1,D2,... or min-automorphisms:K\n");
+    printf("      --predicate-lib=FILE  take the predicate NAME from the shared\n");
+    printf("                        library FILE (see ExtremalPredicate in extremal.h)\n");
+    printf("      --hereditary      the predicate from --predicate-lib is hereditary,\n");
+    printf("                        so the search can prune graphs that fail it\n");
+    printf("      --max-deg=D       only find graphs with maximum degree at most D\n");
+    printf("      --degrees=D1,D2,...  only find graphs whose vertex degrees are all\n");
+    printf("                        in the list\n");
+    printf("      --bipartite       only find bipartite graphs, by only adding\n");
+    printf("                        vertices that keep the graph bipartite\n");
+    printf("      --regular=K       only find K-regular graphs (edge_count must be\n");
+    printf("                        n*K/2), pruning graphs that can't be completed\n");
+    printf("      --time-limit=SECONDS  stop cleanly after SECONDS seconds\n");
+    printf("      --mem-limit=MB    stop cleanly when the search's graphs take more\n");
+    printf("                        than MB megabytes\n");
+    printf("      --unexplored=FILE  where a search stopped by --time-limit or\n");
+    printf("                        --mem-limit writes the subtrees it didn't explore,\n");
+    printf("                        for --from-frontier (default %s)\n", DEFAULT_UNEXPLORED_FILENAME);
+    printf("      --max-lookahead=D  the depth of the tentative lookahead from each\n");
+    printf("                        child, 0 to %d (default %d)\n", MAX_LOOKAHEAD_DEPTH,
+            DEFAULT_LOOKAHEAD_DEPTH);
+    printf("      --adaptive-lookahead  adjust the lookahead depth for each order\n");
+    printf("                        between 0 and --max-lookahead as the search goes\n");
+    printf("      --lookahead-log=FILE  write the adaptive lookahead's decisions to FILE\n");
+    printf("A progress report is also written when the process receives SIGUSR1.\n");
+    printf("\n");
+    printf("Coordinator and workers (see coordinator.h):\n");
+    printf("      --coordinator=SOCKET  run the search to order K, and lease the\n");
+    printf("                        subtrees below it to workers connecting to SOCKET\n");
+    printf("      --lease-order=K   the order of the graphs leased (default %d)\n", DEFAULT_LEASE_ORDER);
+    printf("      --worker=SOCKET   run leases from the coordinator at SOCKET; takes\n");
+    printf("                        no positional arguments\n");
+    printf("      --output-dir=DIR  directory for the workers' output files (default .)\n");
+    printf("\n");
+    printf("Frontiers (see frontier.h):\n");
+    printf("      --emit-frontier=K  run the search to order K only, and write the\n");
+    printf("                        graphs of order K to the --output file\n");
+    printf("      --from-frontier=FILE  search below the graphs in a frontier file\n");
+    printf("      --slice=I/M       with --from-frontier, only search below graphs\n");
+    printf("                        I, I+M, I+2M, ... of the frontier (default 0/1)\n");
 }
 
 int main(int argc, char *argv[])
 {
     setlinebuf(stdout);
 
+    static struct option long_options[] = {
+        {"format", required_argument, NULL, 'f'},
+        {"output", required_argument, NULL, 'o'},
+        {"first", no_argument, NULL, '1'},
+        {"progress", required_argument, NULL, 'p'},
+        {"status-file", required_argument, NULL, 's'},
+        {"capture-corpus", required_argument, NULL, 'c'},
+        {"corpus-size", required_argument, NULL, 'k'},
+        {"summary", required_argument, NULL, 'S'},
+        {"coordinator", required_argument, NULL, 'C'},
+        {"lease-order", required_argument, NULL, 'L'},
+        {"worker", required_argument, NULL, 'W'},
+        {"output-dir", required_argument, NULL, 'D'},
+        {"emit-frontier", required_argument, NULL, 'E'},
+        {"from-frontier", required_argument, NULL, 'F'},
+        {"slice", required_argument, NULL, 'l'},
+        {"subtree-costs", required_argument, NULL, 'T'},
+        {"subtree-order", required_argument, NULL, 'K'},
+        {"predicate", required_argument, NULL, 'P'},
+        {"predicate-lib", required_argument, NULL, 'B'},
+        {"hereditary", no_argument, NULL, 'H'},
+        {"max-deg", required_argument, NULL, 'M'},
+        {"degrees", required_argument, NULL, 'd'},
+        {"regular", required_argument, NULL, 'R'},
+        {"bipartite", no_argument, NULL, 'b'},
+        {"time-limit", required_argument, NULL, 'Y'},
+        {"mem-limit", required_argument, NULL, 'Z'},
+        {"unexplored", required_argument, NULL, 'U'},
+        {"max-lookahead", required_argument, NULL, 'x'},
+        {"adaptive-lookahead", no_argument, NULL, 'a'},
+        {"lookahead-log", required_argument, NULL, 'g'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    enum OutputFormat output_format = OUTPUT_MATRIX;
+    char *output_filename = NULL;
+    int progress_interval = 0;
+    char *status_filename = NULL;
+    int corpus_size = DEFAULT_CORPUS_SIZE;
+    char *summary_filename = NULL;
+    char *coordinator_socket = NULL;
+    int lease_order = DEFAULT_LEASE_ORDER;
+    char *worker_socket = NULL;
+    char *output_dir = ".";
+    int emit_frontier_order = 0;
+    char *frontier_filename = NULL;
+    int slice = 0;
+    int num_slices = 1;
+    char *subtree_costs_filename = NULL;
+    int subtree_order = DEFAULT_SUBTREE_ORDER;
+    char *predicate_spec = NULL;
+    char *predicate_library = NULL;
+    bool predicate_is_hereditary = false;
+    double time_limit = 0;
+    double mem_limit_mb = 0;
+    int max_lookahead = DEFAULT_LOOKAHEAD_DEPTH;
+    bool adaptive_lookahead = false;
+    char *lookahead_log_filename = NULL;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "f:o:h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'f':
+            if (!parse_output_format(optarg, &output_format)) {
+                printf("Unknown output format %s\n", optarg);
+                exit(1);
+            }
+            break;
+        case 'o':
+            output_filename = optarg;
+            break;
+        case '1':
+            global_first_only = true;
+            break;
+        case 'p':
+            progress_interval = atoi(optarg);
+            break;
+        case 's':
+            status_filename = optarg;
+            break;
+        case 'c':
+            global_corpus_filename = optarg;
+            break;
+        case 'k':
+            corpus_size = atoi(optarg);
+            if (corpus_size < 1) {
+                printf("Corpus size must be positive\n");
+                exit(1);
+            }
+            break;
+        case 'S':
+            summary_filename = optarg;
+            break;
+        case 'C':
+            coordinator_socket = optarg;
+            break;
+        case 'L':
+            lease_order = atoi(optarg);
+            break;
+        case 'W':
+            worker_socket = optarg;
+            break;
+        case 'D':
+            output_dir = optarg;
+            break;
+        case 'E':
+            emit_frontier_order = atoi(optarg);
+            break;
+        case 'F':
+            frontier_filename = optarg;
+            break;
+        case 'T':
+            subtree_costs_filename = optarg;
+            break;
+        case 'K':
+            subtree_order = atoi(optarg);
+            if (subtree_order < 1 || subtree_order > MAXN) {
+                printf("The subtree order must be between 1 and %d\n", MAXN);
+                exit(1);
+            }
+            break;
+        case 'P':
+            predicate_spec = optarg;
+            break;
+        case 'B':
+            predicate_library = optarg;
+            break;
+        case 'H':
+            predicate_is_hereditary = true;
+            break;
+        case 'M': {
+            int max_deg = atoi(optarg);
+            if (max_deg < 0 || max_deg >= MAXN) {
+                printf("The maximum degree must be between 0 and %d\n", MAXN-1);
+                exit(1);
+            }
+            global_allowed_degrees &= ALLMASK(max_deg + 1);
+            break;
+        }
+        case 'd': {
+            setword degrees = parse_degree_set(optarg);
+            if (!degrees) {
+                printf("--degrees needs a list of degrees between 0 and %d\n", MAXN-1);
+                exit(1);
+            }
+            global_allowed_degrees &= degrees;
+            break;
+        }
+        case 'R':
+            global_regular_degree = atoi(optarg);
+            if (global_regular_degree < 1 || global_regular_degree >= MAXN) {
+                printf("The degree must be between 1 and %d\n", MAXN-1);
+                exit(1);
+            }
+            global_allowed_degrees &= bit[global_regular_degree];
+            use_distance_profile_tier = true;
+            break;
+        case 'b':
+            global_bipartite = true;
+            break;
+        case 'Y':
+            time_limit = atof(optarg);
+            if (time_limit <= 0) {
+                printf("The time limit must be positive\n");
+                exit(1);
+            }
+            break;
+        case 'Z':
+            mem_limit_mb = atof(optarg);
+            if (mem_limit_mb <= 0) {
+                printf("The memory limit must be positive\n");
+                exit(1);
+            }
+            break;
+        case 'U':
+            unexplored_filename = optarg;
+            break;
+        case 'x':
+            max_lookahead = atoi(optarg);
+            if (max_lookahead < 0 || max_lookahead > MAX_LOOKAHEAD_DEPTH) {
+                printf("The lookahead depth must be from 0 to %d\n", MAX_LOOKAHEAD_DEPTH);
+                exit(1);
+            }
+            break;
+        case 'a':
+            adaptive_lookahead = true;
+            break;
+        case 'g':
+            lookahead_log_filename = optarg;
+            break;
+        case 'l':
+            if (!parse_slice(optarg, &slice, &num_slices)) {
+                printf("A slice must be I/M with 0 <= I < M\n");
+                exit(1);
+            }
+            break;
+        case 'h':
+            print_usage();
+            exit(0);
+        default:
+            print_usage();
+            exit(1);
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+
+    if (predicate_spec) {
+        set_predicate(predicate_spec, predicate_library, predicate_is_hereditary);
+    } else if (predicate_library || predicate_is_hereditary) {
+        printf("--predicate-lib and --hereditary need --predicate.\n");
+        exit(1);
+    }
+
+    FILE *lookahead_log = NULL;
+    if (lookahead_log_filename) {
+        if (!adaptive_lookahead) {
+            printf("--lookahead-log needs --adaptive-lookahead.\n");
+            exit(1);
+        }
+        lookahead_log = fopen(lookahead_log_filename, "w");
+        if (!lookahead_log) {
+            printf("Can't open %s for writing\n", lookahead_log_filename);
+            exit(1);
+        }
+    }
+    set_lookahead(max_lookahead, adaptive_lookahead, lookahead_log);
+
+    if (subtree_costs_filename)
+        start_subtree_costs(subtree_order, subtree_costs_filename, num_visited_by_order,
+                &global_graph_count, &canonicalisation_calls);
+
+    if (worker_socket) {
+        if (time_limit || mem_limit_mb) {
+            printf("--time-limit and --mem-limit can't be used by workers.\n");
+            exit(1);
+        }
+        if (output_filename) {
+            printf("Workers write to --output-dir, not --output.\n");
+            exit(1);
+        }
+        run_worker(worker_socket, output_format, output_dir);
+        finish_subtree_costs();
+        if (lookahead_log)
+            fclose(lookahead_log);
+        clean_up_graph_type_lists();
+        exit(0);
+    }
+
     if (argc < 4) {
         printf("Not enough arguments.\n");
         printf("Required: min girth, n, max edge count.\n");
@@ -398,13 +1159,92 @@ int main(int argc, char *argv[])
         printf("Min girth must be >= 5\n");
         exit(1);
     }
+    // A bipartite graph has no odd cycles, so odd girths can be rounded up.
+    // This is done before anything records the girth, so that the output,
+    // frontiers and summary all agree
+    if (global_bipartite && MIN_GIRTH % 2)
+        MIN_GIRTH++;
     int n = atoi(argv[2]);
     int edge_count = atoi(argv[3]);
+    if (global_regular_degree && 2 * edge_count != n * global_regular_degree) {
+        printf("A %d-regular graph of order %d has %d edges, not %d.\n", global_regular_degree,
+                n, n * global_regular_degree / 2, edge_count);
+        exit(1);
+    }
     if (argc > 4) {
+        if (argc < 7) {
+            printf("Splitting requires low level, high level and split number.\n");
+            exit(1);
+        }
         global_low_splitting_level = atoi(argv[4]);
         global_high_splitting_level = atoi(argv[5]);
         global_split_number = atoi(argv[6]);
     }
+    if (coordinator_socket) {
+        if (argc > 4) {
+            printf("A coordinator can't be used with splitting.\n");
+            exit(1);
+        }
+        if (lease_order < 2 || lease_order >= n) {
+            printf("The lease order must be at least 2 and less than n.\n");
+            exit(1);
+        }
+    }
+    if ((time_limit || mem_limit_mb) && (argc > 4 || coordinator_socket)) {
+        printf("--time-limit and --mem-limit can't be used with splitting or a coordinator.\n");
+        exit(1);
+    }
+    if (emit_frontier_order || frontier_filename) {
+        if (argc > 4 || coordinator_socket) {
+            printf("A frontier can't be used with splitting or a coordinator.\n");
+            exit(1);
+        }
+    }
+    if (emit_frontier_order) {
+        if (emit_frontier_order < 2 || emit_frontier_order >= n) {
+            printf("The frontier order must be at least 2 and less than n.\n");
+            exit(1);
+        }
+        if (!output_filename) {
+            printf("--emit-frontier requires --output.\n");
+            exit(1);
+        }
+    }
+    struct Frontier frontier;
+    if (frontier_filename) {
+        if (!frontier_read(frontier_filename, slice, num_slices, &frontier))
+            exit(1);
+        if (frontier.min_girth != MIN_GIRTH || frontier.n != n || frontier.edge_count != edge_count) {
+            printf("%s was written for a different search.\n", frontier_filename);
+            exit(1);
+        }
+        // One frontier can be made from another, one or more levels on
+        if (emit_frontier_order && (frontier.order == 0 || frontier.order >= emit_frontier_order)) {
+            printf("The frontier order must be greater than that of %s.\n", frontier_filename);
+            exit(1);
+        }
+    }
+
+    FILE *output_file = stdout;
+    if (emit_frontier_order) {
+        frontier_file = fopen(output_filename, "w");
+        if (!frontier_file) {
+            printf("Can't open %s for writing\n", output_filename);
+            exit(1);
+        }
+        frontier_write_header(frontier_file, MIN_GIRTH, n, edge_count, emit_frontier_order);
+    } else if (output_filename) {
+        output_file = fopen(output_filename, "w");
+        if (!output_file) {
+            printf("Can't open %s for writing\n", output_filename);
+            exit(1);
+        }
+    } else if (output_format == OUTPUT_BINARY) {
+        printf("Binary output requires an output file.\n");
+        exit(1);
+    }
+    set_graph_output(output_format, output_file, MIN_GIRTH, n, edge_count,
+            frontier_filename ? slice : global_split_number);
 
     global_n = n;
 
@@ -420,15 +1260,92 @@ int main(int argc, char *argv[])
 
     nauty_check(WORDSIZE,m,n,NAUTYVERSIONID);
 
-    find_extremal_graphs(n, edge_count);
+    if (global_corpus_filename)
+        corpus_start(corpus_size, max_lookahead);
+
+    INSTR_START();
+
+    start_progress(progress_interval, status_filename, n, num_visited_by_order,
+            &global_graph_count, &canonicalisation_calls);
+
+    unexplored_min_girth = MIN_GIRTH;
+    unexplored_n = n;
+    unexplored_edge_count = edge_count;
+    set_budgets(time_limit, (unsigned long long) (mem_limit_mb * 1024 * 1024), write_unexplored_graph);
+
+    if (coordinator_socket) {
+        run_coordinator(coordinator_socket, lease_order, MIN_GIRTH, n, edge_count);
+    } else if (emit_frontier_order) {
+        global_frontier_order = emit_frontier_order;
+        global_frontier_callback = emit_frontier_graph;
+        if (frontier_filename) {
+            search_frontier(&frontier, edge_count);
+            free(frontier.graphs);
+        } else {
+            find_extremal_graphs(MIN_GIRTH, n, edge_count);
+        }
+        frontier_write_end(frontier_file, frontier_count);
+        if (fclose(frontier_file) != 0) {
+            printf("Can't write %s\n", output_filename);
+            exit(1);
+        }
+        printf("Frontier: %lld graphs of order %d\n", frontier_count, emit_frontier_order);
+    } else if (frontier_filename) {
+        search_frontier(&frontier, edge_count);
+        free(frontier.graphs);
+    } else {
+        find_extremal_graphs(MIN_GIRTH, n, edge_count);
+    }
+
+    close_graph_output();
+    finish_subtree_costs();
+
+    if (global_corpus_filename)
+        corpus_write(global_corpus_filename, MIN_GIRTH, n, edge_count);
 
     printf("visited");
     for (int i=0; i<MAXN; i++)
         printf(" %llu", num_visited_by_order[i]);
     printf("\n");
 
+    if (adaptive_lookahead)
+        print_lookahead_depths(stdout);
+    if (lookahead_log && fclose(lookahead_log) != 0) {
+        printf("Can't write %s\n", lookahead_log_filename);
+        exit(1);
+    }
+
     printf("Canonicalisation calls: %lld\n", canonicalisation_calls);
+    if (global_budget_exhausted) {
+        open_unexplored_file();
+        frontier_write_end(unexplored_file, unexplored_count);
+        if (fclose(unexplored_file) != 0) {
+            printf("Can't write %s\n", unexplored_filename);
+            exit(1);
+        }
+        printf("Search incomplete: out of %s, %lld unexplored subtrees written to %s\n",
+                global_budget_exhausted, unexplored_count, unexplored_filename);
+    } else if (global_search_stopped) {
+        printf("Search stopped at the first graph found\n");
+    }
     printf("Total graph count: %llu\n", global_graph_count);
 
+    // An incomplete count would mislead the summary
+    if (summary_filename && global_graph_count && !global_budget_exhausted) {
+        FILE *f = fopen(summary_filename, "a");
+        if (!f) {
+            printf("Can't open %s for appending\n", summary_filename);
+            exit(1);
+        }
+        fprintf(f, "%d %d %d %llu\n", MIN_GIRTH, n, edge_count, global_graph_count);
+        fclose(f);
+    }
+
+    INSTR_WRITE_TABLE(stderr);
+
     clean_up_graph_type_lists();
+
+    return global_budget_exhausted ? 2 : 0;
 }
+
+#endif   // EXTREMAL_LIBRARY
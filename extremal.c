@@ -0,0 +1,124 @@
+#include "graph_plus.h"
+#include "canonical_deletion.h"
+#include "possible_graph_types.h"
+#include "search.h"
+#include "util.h"
+#include "extremal.h"
+
+#include <string.h>
+
+#if EXTREMAL_MAX_N != MAXN
+#error "EXTREMAL_MAX_N must equal MAXN"
+#endif
+
+struct EcdIter {
+    struct SearchIter search;
+    bool empty;         // a split shard with nothing to search
+    bool finished;
+};
+
+static bool iter_active = false;
+
+struct EcdIter *ecd_iter_start(const struct ExtremalParams *params)
+{
+    if (iter_active)
+        return NULL;
+    if (params->min_girth < 5 || params->n < 1 || params->n > MAXN || params->edge_count < 0)
+        return NULL;
+    if (params->regular_degree &&
+            (params->regular_degree < 0 || params->regular_degree >= MAXN ||
+             2 * params->edge_count != params->n * params->regular_degree))
+        return NULL;
+    if (params->low_splitting_level > 0 &&
+            (params->high_splitting_level < params->low_splitting_level || params->split_number < 0))
+        return NULL;
+
+    global_low_splitting_level = params->low_splitting_level;
+    global_high_splitting_level = params->high_splitting_level;
+    global_split_number = params->split_number;
+    global_first_only = params->first_only;
+    global_predicate = params->predicate;
+    global_predicate_arg = params->predicate_arg;
+    global_predicate_is_hereditary = params->predicate && params->predicate_is_hereditary;
+    global_allowed_degrees = ~(setword) 0;
+    if (params->max_deg > 0 && params->max_deg < MAXN)
+        global_allowed_degrees = ALLMASK(params->max_deg + 1);
+    if (params->allowed_degrees) {
+        setword allowed = 0;
+        for (int d=0; d<MAXN; d++)
+            if (params->allowed_degrees & ((uint64_t) 1 << d))
+                allowed |= bit[d];
+        global_allowed_degrees &= allowed;
+    }
+    global_regular_degree = params->regular_degree;
+    if (global_regular_degree)
+        global_allowed_degrees &= bit[global_regular_degree];
+    use_distance_profile_tier = global_regular_degree != 0;
+    global_bipartite = params->bipartite;
+    global_search_stopped = false;
+    global_graph_count = 0;
+    canonicalisation_calls = 0;
+    memset(num_visited_by_order, 0, sizeof num_visited_by_order);
+
+    struct EcdIter *it = emalloc(sizeof *it);
+    // A bipartite graph has no odd cycles, so odd girths can be rounded up
+    int min_girth = params->bipartite && params->min_girth % 2 ? params->min_girth + 1
+                                                               : params->min_girth;
+    it->empty = !search_iter_start_full(&it->search, min_girth, params->n,
+            params->edge_count);
+    it->finished = it->empty;
+    iter_active = true;
+    return it;
+}
+
+const uint64_t *ecd_iter_next(struct EcdIter *it, int *n, int *edge_count)
+{
+    if (it->finished)
+        return NULL;
+    struct GraphPlus *gp = search_iter_next(&it->search);
+    if (!gp) {
+        it->finished = true;
+        return NULL;
+    }
+    *n = gp->n;
+    *edge_count = gp->edge_count;
+    return (const uint64_t *) gp->graph;
+}
+
+void ecd_iter_counts(struct EcdIter *it, struct ExtremalCounts *counts)
+{
+    counts->graph_count = global_graph_count;
+    memcpy(counts->visited_by_order, num_visited_by_order, sizeof counts->visited_by_order);
+    counts->canonicalisation_calls = canonicalisation_calls;
+    counts->stopped = global_search_stopped;
+}
+
+void ecd_iter_finish(struct EcdIter *it)
+{
+    if (!it->finished) {
+        global_search_stopped = true;
+        while (search_iter_next(&it->search))
+            ;
+    }
+    if (!it->empty)
+        clean_up_graph_type_lists();
+    free(it);
+    iter_active = false;
+}
+
+int extremal_search(const struct ExtremalParams *params, ExtremalGraphCallback callback,
+        void *user_data, struct ExtremalCounts *counts)
+{
+    struct EcdIter *it = ecd_iter_start(params);
+    if (!it)
+        return -1;
+    const uint64_t *rows;
+    int n, edge_count;
+    while ((rows = ecd_iter_next(it, &n, &edge_count)))
+        if (callback && callback(rows, n, edge_count, user_data))
+            global_search_stopped = true;
+    if (counts)
+        ecd_iter_counts(it, counts);
+    ecd_iter_finish(it);
+    return 0;
+}
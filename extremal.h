@@ -0,0 +1,99 @@
+#ifndef EXTREMAL_H
+#define EXTREMAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The search for extremal graphs of given girth, as a library (libextremal.a,
+// or libextremal.so where nauty has been built with -fPIC).
+//
+// The search uses global state, so only one search may be in progress at a
+// time in a process, but any number may be run one after another.
+
+#define EXTREMAL_MAX_N 64
+
+// A condition on the graphs found, in addition to girth and edge count.
+// rows are as for ExtremalGraphCallback, below, and arg is the argument
+// given with the predicate (or NULL).  Returns non-zero if the graph is
+// accepted.
+//
+// A predicate is hereditary if every induced subgraph of an accepted graph
+// is accepted.  Since the search builds each graph from one of its induced
+// subgraphs, a hereditary predicate is applied to every graph visited, and
+// prunes the subtree below each graph that it rejects; any other predicate
+// is only applied to the graphs of order n.
+typedef int (*ExtremalPredicate)(const uint64_t *rows, int n, const char *arg);
+
+struct ExtremalParams {
+    int min_girth;              // at least 5
+    int n;                      // between 1 and EXTREMAL_MAX_N
+    int edge_count;
+    // Splitting, as with the optional command-line arguments of
+    // ex_max_canonical_deletions; leave all three 0 to search the whole tree
+    int low_splitting_level;
+    int high_splitting_level;
+    int split_number;
+    bool first_only;            // stop after the first graph found
+    ExtremalPredicate predicate;    // NULL if there is none
+    const char *predicate_arg;
+    bool predicate_is_hereditary;
+    // Degree restrictions, which unlike a predicate are built into the
+    // search: max_deg caps the maximum degree (0 for no cap), and if
+    // allowed_degrees is not 0, every vertex's degree d must have the bit
+    // (uint64_t) 1 << d set in it
+    int max_deg;
+    uint64_t allowed_degrees;
+    // If not 0, only find regular graphs of this degree, pruning graphs
+    // that can't be completed to one; edge_count must be n*regular_degree/2
+    int regular_degree;
+    bool bipartite;             // only find bipartite graphs
+};
+
+struct ExtremalCounts {
+    unsigned long long graph_count;
+    unsigned long long visited_by_order[EXTREMAL_MAX_N];
+    long long canonicalisation_calls;
+    bool stopped;               // by first_only or by the callback
+};
+
+// Called for each graph found.  Row i of the adjacency matrix is rows[i], in
+// which vertex j is the bit (uint64_t) 1 << (63 - j), as in nauty.  The rows
+// belong to the search, and are only valid for the duration of the call.
+// Returning non-zero stops the search.
+typedef int (*ExtremalGraphCallback)(const uint64_t *rows, int n, int edge_count,
+        void *user_data);
+
+// Looks up a built-in predicate by name: "bipartite", "connected",
+// "max-diameter" (arg: the diameter), "degrees" (arg: the allowed degrees,
+// separated by commas) or "min-automorphisms" (arg: the least size of the
+// automorphism group).  Returns false if there is no such predicate.
+bool extremal_builtin_predicate(const char *name, ExtremalPredicate *predicate,
+        bool *is_hereditary);
+
+// Runs a search.  callback may be NULL to only count the graphs; counts may
+// be NULL if they aren't wanted.  Returns 0, or -1 if the parameters are
+// invalid or another search is in progress.
+int extremal_search(const struct ExtremalParams *params, ExtremalGraphCallback callback,
+        void *user_data, struct ExtremalCounts *counts);
+
+// The same search, but run a step at a time by the caller: the search is
+// suspended whenever it finds a graph, with its state held in a fixed-size
+// stack, so nothing is buffered however slowly the graphs are consumed.
+struct EcdIter;
+
+// Returns NULL if the parameters are invalid or another search is in
+// progress
+struct EcdIter *ecd_iter_start(const struct ExtremalParams *params);
+
+// Runs the search until it finds another graph, and returns its rows (as for
+// ExtremalGraphCallback, valid until the next call), or returns NULL once the
+// search is finished
+const uint64_t *ecd_iter_next(struct EcdIter *it, int *n, int *edge_count);
+
+// The counts so far
+void ecd_iter_counts(struct EcdIter *it, struct ExtremalCounts *counts);
+
+// Ends the search, whether or not it is finished, and frees it
+void ecd_iter_finish(struct EcdIter *it);
+
+#endif
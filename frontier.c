@@ -0,0 +1,100 @@
+#include "graph_plus.h"
+#include "frontier.h"
+#include "util.h"
+
+#include <string.h>
+
+void frontier_write_header(FILE *f, int min_girth, int n, int edge_count, int order)
+{
+    fprintf(f, "frontier %d %d %d %d %d\n", FRONTIER_VERSION, min_girth, n, edge_count, order);
+}
+
+void frontier_write_graph(FILE *f, struct GraphPlus *gp)
+{
+    fprintf(f, "%d %d %d", gp->edge_count, gp->min_deg, gp->max_deg);
+    for (int i=0; i<gp->n; i++)
+        fprintf(f, " %llx", (unsigned long long) gp->graph[i]);
+    fprintf(f, "\n");
+}
+
+void frontier_write_mixed_graph(FILE *f, struct GraphPlus *gp)
+{
+    fprintf(f, "%d ", gp->n);
+    frontier_write_graph(f, gp);
+}
+
+void frontier_write_end(FILE *f, long long num_graphs)
+{
+    fprintf(f, "end %lld\n", num_graphs);
+}
+
+static bool read_graph(FILE *f, int order, int n, struct GraphPlus *gp)
+{
+    if (order == 0 && (fscanf(f, "%d", &order) != 1 || order < 1 || order > n))
+        return false;
+    int edge_count, min_deg, max_deg;
+    if (fscanf(f, "%d %d %d", &edge_count, &min_deg, &max_deg) != 3)
+        return false;
+    graph g[MAXN];
+    EMPTYGRAPH(g, 1, MAXN);
+    for (int i=0; i<order; i++) {
+        unsigned long long row;
+        if (fscanf(f, "%llx", &row) != 1)
+            return false;
+        g[i] = row;
+    }
+    make_graph_plus(g, order, edge_count, min_deg, max_deg, gp);
+    return true;
+}
+
+bool frontier_read(char *filename, int slice, int num_slices, struct Frontier *fr)
+{
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        fprintf(stderr, "Can't open %s\n", filename);
+        return false;
+    }
+    int version;
+    if (fscanf(f, "frontier %d %d %d %d %d", &version, &fr->min_girth, &fr->n,
+                &fr->edge_count, &fr->order) != 5 ||
+            version != FRONTIER_VERSION || fr->order < 0 || fr->order >= fr->n || fr->n > MAXN) {
+        fprintf(stderr, "%s is not a valid frontier\n", filename);
+        fclose(f);
+        return false;
+    }
+
+    long long size = 1024;
+    fr->num_graphs = 0;
+    fr->graphs = emalloc(size * sizeof *fr->graphs);
+    long long expected_count = -1;
+    long long count = 0;
+    for (;; count++) {
+        if (fscanf(f, " end %lld", &expected_count) == 1)
+            break;
+        if (fr->num_graphs == size) {
+            size *= 2;
+            struct GraphPlus *graphs = emalloc(size * sizeof *graphs);
+            memcpy(graphs, fr->graphs, fr->num_graphs * sizeof *graphs);
+            free(fr->graphs);
+            fr->graphs = graphs;
+        }
+        if (!read_graph(f, fr->order, fr->n, &fr->graphs[fr->num_graphs]))
+            break;
+        if (count % num_slices == slice)
+            fr->num_graphs++;
+    }
+    fclose(f);
+    if (expected_count != count) {
+        fprintf(stderr, "%s is truncated or corrupt\n", filename);
+        free(fr->graphs);
+        return false;
+    }
+    return true;
+}
+
+bool parse_slice(char *s, int *slice, int *num_slices)
+{
+    char c;
+    return sscanf(s, "%d/%d%c", slice, num_slices, &c) == 2 &&
+            *num_slices > 0 && *slice >= 0 && *slice < *num_slices;
+}
@@ -0,0 +1,50 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+// A frontier file lists the canonical graphs of one order that the search
+// visits at tentativeness level 0, so that the subtrees below them can be
+// searched by separate processes without each repeating the top of the
+// tree.
+//
+// The file is text.  The first line is
+//     frontier VERSION min_girth n edge_count order
+// and each graph is a line
+//     edge_count min_deg max_deg row_0 ... row_{order-1}
+// with the rows as hexadecimal setwords.  The last line is
+//     end graph_count
+// so that a truncated file is detected.
+//
+// A frontier of mixed orders, such as the unexplored subtrees left by a
+// search that ran out of time or memory, has order 0 in its first line,
+// and each graph line starts with the graph's order, from 1 to n.
+
+#define FRONTIER_VERSION 1
+
+struct Frontier {
+    int min_girth;
+    int n;              // the order of the graphs being searched for
+    int edge_count;
+    int order;          // the order of the graphs in the frontier, or 0 if mixed
+    long long num_graphs;
+    struct GraphPlus *graphs;
+};
+
+void frontier_write_header(FILE *f, int min_girth, int n, int edge_count, int order);
+
+void frontier_write_graph(FILE *f, struct GraphPlus *gp);
+
+// Writes a graph of a frontier of mixed orders
+void frontier_write_mixed_graph(FILE *f, struct GraphPlus *gp);
+
+void frontier_write_end(FILE *f, long long num_graphs);
+
+// Reads slice i of m of a frontier (see parse_slice) into fr, with the
+// graphs in a newly allocated array; the rest of the file is checked but not
+// kept, so that a process searching one slice only holds that slice.
+// Returns false, having printed a message to stderr, if the file can't be
+// read or isn't a valid frontier
+bool frontier_read(char *filename, int slice, int num_slices, struct Frontier *fr);
+
+// Parses a slice "i/m", with 0 <= i < m.  Slice i of m is the graphs whose
+// index in the frontier is congruent to i modulo m.
+bool parse_slice(char *s, int *slice, int *num_slices);
@@ -0,0 +1,110 @@
+#include "graph_plus.h"
+#include "graph_container.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void write_or_die(void *buf, size_t size, FILE *f)
+{
+    if (fwrite(buf, size, 1, f) != 1) {
+        fprintf(stderr, "Failed to write container\n");
+        exit(1);
+    }
+}
+
+void container_writer_open(struct ContainerWriter *w, FILE *f, int min_girth, int n,
+        int edge_count, int shard_id)
+{
+    w->f = f;
+    w->header = (struct ContainerHeader) {
+        .version = CONTAINER_VERSION,
+        .min_girth = min_girth,
+        .n = n,
+        .edge_count = edge_count,
+        .shard_id = shard_id,
+        .num_shards = 1,
+        .graph_count = 0,
+        .index_offset = 0
+    };
+    memcpy(w->header.magic, CONTAINER_MAGIC, sizeof w->header.magic);
+
+    // The header is rewritten with the final counts by container_writer_close
+    write_or_die(&w->header, sizeof w->header, f);
+}
+
+void container_writer_add(struct ContainerWriter *w, setword *g)
+{
+    uint64_t rows[MAXN];
+    for (int i=0; i<w->header.n; i++)
+        rows[i] = g[i];
+    write_or_die(rows, w->header.n * sizeof(uint64_t), w->f);
+    w->header.graph_count++;
+}
+
+void container_writer_close(struct ContainerWriter *w)
+{
+    w->header.index_offset = sizeof w->header + w->header.graph_count * w->header.n * sizeof(uint64_t);
+    struct ContainerIndexEntry entry = {
+        .shard_id = w->header.shard_id,
+        .first_graph = 0,
+        .graph_count = w->header.graph_count
+    };
+    write_or_die(&entry, sizeof entry, w->f);
+    if (fseek(w->f, 0, SEEK_SET) != 0) {
+        fprintf(stderr, "Can't seek to the start of the container; is it a regular file?\n");
+        exit(1);
+    }
+    write_or_die(&w->header, sizeof w->header, w->f);
+    fflush(w->f);
+}
+
+bool container_open(char *filename, struct Container *c)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "Can't open %s\n", filename);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t) st.st_size < sizeof(struct ContainerHeader)) {
+        fprintf(stderr, "%s is too short to be a container\n", filename);
+        close(fd);
+        return false;
+    }
+    c->size = st.st_size;
+    c->data = mmap(NULL, c->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (c->data == MAP_FAILED) {
+        fprintf(stderr, "Can't map %s\n", filename);
+        return false;
+    }
+
+    c->header = c->data;
+    c->graphs = (uint64_t *) ((char *) c->data + sizeof(struct ContainerHeader));
+    c->index = (struct ContainerIndexEntry *) ((char *) c->data + c->header->index_offset);
+
+    struct ContainerHeader *h = c->header;
+    if (memcmp(h->magic, CONTAINER_MAGIC, sizeof h->magic) || h->version != CONTAINER_VERSION ||
+            h->n > MAXN ||
+            h->index_offset != sizeof *h + h->graph_count * h->n * sizeof(uint64_t) ||
+            h->index_offset + h->num_shards * sizeof(struct ContainerIndexEntry) > c->size) {
+        fprintf(stderr, "%s is not a valid container\n", filename);
+        container_close(c);
+        return false;
+    }
+    return true;
+}
+
+uint64_t * container_graph(struct Container *c, uint64_t k)
+{
+    return c->graphs + k * c->header->n;
+}
+
+void container_close(struct Container *c)
+{
+    munmap(c->data, c->size);
+    c->data = NULL;
+}
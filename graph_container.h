@@ -0,0 +1,65 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// A binary file of graphs with at most 64 vertices.  The file begins with a
+// struct ContainerHeader.  It is followed by graph_count graphs, each of
+// which is n 64-bit rows as in struct GraphPlus, and then by an index of
+// num_shards struct ContainerIndexEntry recording which graphs came from
+// which shard.  Everything is in native byte order.
+
+#define CONTAINER_MAGIC "ECDGRAPH"
+#define CONTAINER_VERSION 1
+
+// The shard_id of a file that was made by merging shards
+#define CONTAINER_MERGED 0xFFFFFFFFu
+
+struct ContainerHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t min_girth;
+    uint32_t n;
+    uint32_t edge_count;
+    uint32_t shard_id;
+    uint32_t num_shards;
+    uint64_t graph_count;
+    uint64_t index_offset;
+};
+
+struct ContainerIndexEntry {
+    uint32_t shard_id;
+    uint32_t padding;
+    uint64_t first_graph;
+    uint64_t graph_count;
+};
+
+struct ContainerWriter {
+    FILE *f;
+    struct ContainerHeader header;
+};
+
+// A container opened for reading with container_open
+struct Container {
+    void *data;
+    size_t size;
+    struct ContainerHeader *header;
+    uint64_t *graphs;
+    struct ContainerIndexEntry *index;
+};
+
+void container_writer_open(struct ContainerWriter *w, FILE *f, int min_girth, int n,
+        int edge_count, int shard_id);
+
+void container_writer_add(struct ContainerWriter *w, setword *g);
+
+// Writes the index and the final header; does not close w->f
+void container_writer_close(struct ContainerWriter *w);
+
+// Returns false, having printed a message to stderr, if the file can't be
+// mapped or isn't a valid container
+bool container_open(char *filename, struct Container *c);
+
+// The rows of graph k
+uint64_t * container_graph(struct Container *c, uint64_t k);
+
+void container_close(struct Container *c);
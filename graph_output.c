@@ -0,0 +1,201 @@
+#include "graph_plus.h"
+#include "graph_output.h"
+#include "graph_util.h"
+#include "graph_container.h"
+
+#include <string.h>
+
+#define OUTPUT_BUFFER_SIZE (1 << 22)
+
+static enum OutputFormat output_format = OUTPUT_MATRIX;
+static FILE *output_file = NULL;
+static struct ContainerWriter container_writer;
+
+// graph6 and sparse6 lines are collected here, and written with one fwrite
+// call per OUTPUT_BUFFER_SIZE bytes or so
+static char output_buffer[OUTPUT_BUFFER_SIZE];
+static size_t output_buffer_len = 0;
+
+bool parse_output_format(char *format_name, enum OutputFormat *format)
+{
+    if (!strcmp(format_name, "matrix"))
+        *format = OUTPUT_MATRIX;
+    else if (!strcmp(format_name, "graph6"))
+        *format = OUTPUT_GRAPH6;
+    else if (!strcmp(format_name, "sparse6"))
+        *format = OUTPUT_SPARSE6;
+    else if (!strcmp(format_name, "binary"))
+        *format = OUTPUT_BINARY;
+    else
+        return false;
+    return true;
+}
+
+void set_graph_output(enum OutputFormat format, FILE *f, int min_girth, int n,
+        int edge_count, int shard_id)
+{
+    flush_graph_output();
+    output_format = format;
+    output_file = f;
+    if (format == OUTPUT_BINARY) {
+        // Rows are written straight to the file, so give it a large buffer
+        setvbuf(f, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+        container_writer_open(&container_writer, f, min_girth, n, edge_count, shard_id);
+    }
+}
+
+void flush_graph_output()
+{
+    if (output_buffer_len == 0)
+        return;
+    FILE *f = output_file ? output_file : stdout;
+    if (fwrite(output_buffer, 1, output_buffer_len, f) != output_buffer_len) {
+        fprintf(stderr, "Failed to write graphs\n");
+        exit(1);
+    }
+    fflush(f);
+    output_buffer_len = 0;
+}
+
+void close_graph_output()
+{
+    flush_graph_output();
+    if (output_format == OUTPUT_BINARY)
+        container_writer_close(&container_writer);
+    if (output_file && output_file != stdout)
+        fclose(output_file);
+    output_file = NULL;
+}
+
+void write_graph(struct GraphPlus *gp)
+{
+    if (output_format == OUTPUT_MATRIX) {
+        show_graph(output_file ? output_file : stdout, gp);
+        return;
+    }
+
+    if (output_format == OUTPUT_BINARY) {
+        container_writer_add(&container_writer, gp->graph);
+        return;
+    }
+
+    if (output_buffer_len + MAX_ENCODED_GRAPH_LEN > OUTPUT_BUFFER_SIZE)
+        flush_graph_output();
+    char *s = output_buffer + output_buffer_len;
+    if (output_format == OUTPUT_GRAPH6)
+        output_buffer_len += graph_to_graph6(gp->graph, gp->n, s);
+    else
+        output_buffer_len += graph_to_sparse6(gp->graph, gp->n, s);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//  graph6 and sparse6, as described in formats.txt in the nauty distribution
+////////////////////////////////////////////////////////////////////////////////
+
+// Writes N(n); returns the number of characters written
+static int encode_order(int n, char *s)
+{
+    if (n <= 62) {
+        s[0] = 63 + n;
+        return 1;
+    }
+    s[0] = 126;
+    s[1] = 63 + ((n >> 12) & 63);
+    s[2] = 63 + ((n >> 6) & 63);
+    s[3] = 63 + (n & 63);
+    return 4;
+}
+
+int graph_to_graph6(graph *g, int n, char *s)
+{
+    int len = encode_order(n, s);
+
+    // The upper triangle, column by column, six bits per character
+    int x = 0;
+    int k = 6;
+    for (int j=1; j<n; j++) {
+        for (int i=0; i<j; i++) {
+            x <<= 1;
+            if (ISELEMENT(&g[i], j))
+                x |= 1;
+            if (--k == 0) {
+                s[len++] = 63 + x;
+                x = 0;
+                k = 6;
+            }
+        }
+    }
+    if (k != 6)
+        s[len++] = 63 + (x << k);
+
+    s[len++] = '\n';
+    s[len] = '\0';
+    return len;
+}
+
+struct Sparse6Writer {
+    char *s;
+    int len;
+    int x;      // bits not yet written
+    int k;      // number of bits still needed to complete a character
+};
+
+static void sparse6_put_bits(struct Sparse6Writer *w, int val, int num_bits)
+{
+    for (int b=num_bits-1; b>=0; b--) {
+        w->x = (w->x << 1) | ((val >> b) & 1);
+        if (--w->k == 0) {
+            w->s[w->len++] = 63 + w->x;
+            w->x = 0;
+            w->k = 6;
+        }
+    }
+}
+
+int graph_to_sparse6(graph *g, int n, char *s)
+{
+    s[0] = ':';
+    struct Sparse6Writer w = {s, 1, 0, 6};
+    w.len += encode_order(n, s + 1);
+
+    // nb is the number of bits needed to write a vertex number
+    int nb = 0;
+    for (int i=n-1; i>0; i>>=1)
+        nb++;
+
+    // Each edge {i,j} with i<=j is written as the bit b and the vertex i,
+    // where b is 1 if j is one more than the previous value of j.  If j
+    // is larger than that, we first write a 1 followed by j, then a 0.
+    int lastj = 0;
+    for (int j=0; j<n; j++) {
+        setword row = g[j] & ~BITMASK(j);   // neighbours i<=j
+        while (row) {
+            int i;
+            TAKEBIT(i, row);
+            if (j == lastj) {
+                sparse6_put_bits(&w, 0, 1);
+            } else {
+                sparse6_put_bits(&w, 1, 1);
+                if (j > lastj + 1) {
+                    sparse6_put_bits(&w, j, nb);
+                    sparse6_put_bits(&w, 0, 1);
+                }
+                lastj = j;
+            }
+            sparse6_put_bits(&w, i, nb);
+        }
+    }
+
+    // Pad with 1-bits, except in a special case where that padding could
+    // be read as an extra edge
+    if (w.k != 6) {
+        if (w.k >= nb + 1 && lastj == n - 2 && n == (1 << nb))
+            sparse6_put_bits(&w, (1 << (w.k - 1)) - 1, w.k);
+        else
+            sparse6_put_bits(&w, (1 << w.k) - 1, w.k);
+    }
+
+    s[w.len++] = '\n';
+    s[w.len] = '\0';
+    return w.len;
+}
@@ -0,0 +1,32 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+enum OutputFormat {OUTPUT_MATRIX, OUTPUT_GRAPH6, OUTPUT_SPARSE6, OUTPUT_BINARY};
+
+// The longest line that graph_to_graph6 or graph_to_sparse6 can write,
+// including the newline and terminating null
+#define MAX_ENCODED_GRAPH_LEN 8192
+
+// Returns false if format_name is not recognised
+bool parse_output_format(char *format_name, enum OutputFormat *format);
+
+// The remaining arguments describe the search, and are only used for the
+// header of a binary container (see graph_container.h), for which f must be
+// a regular file
+void set_graph_output(enum OutputFormat format, FILE *f, int min_girth, int n,
+        int edge_count, int shard_id);
+
+// Writes gp in the format chosen by set_graph_output (by default, as an
+// adjacency matrix to stdout)
+void write_graph(struct GraphPlus *gp);
+
+void flush_graph_output();
+
+// Flushes the output, finishes a binary container, and closes the output
+// file unless it is stdout
+void close_graph_output();
+
+// These write a null-terminated line to s, and return its length
+int graph_to_graph6(graph *g, int n, char *s);
+
+int graph_to_sparse6(graph *g, int n, char *s);
@@ -3,6 +3,10 @@
 
 #include <stdbool.h>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 int nb_deg_sum(graph *g, int v, int *degs) {
     int deg_sum = 0;
     setword nb = g[v];
@@ -60,7 +64,9 @@ int num_neighbours_of_deg_d(graph *g, int v, int d, int *degs) {
 }
 
 // Which pairs of vertices have a path of length max_path_len or less?
-void all_pairs_check_for_short_path(graph *g, int n, int max_path_len, setword *have_short_path)
+// This is the original version, which tests every pair of vertices for each
+// path length.  It is kept as a reference for microbench_short_path.
+void all_pairs_check_for_short_path_pairwise(graph *g, int n, int max_path_len, setword *have_short_path)
 {
     for (int i=0; i<n; i++) {
         have_short_path[i] = g[i] | bit[i];
@@ -85,6 +91,152 @@ void all_pairs_check_for_short_path(graph *g, int n, int max_path_len, setword *
     }
 }
 
+// The ball of radius max_path_len around v, built by OR-ing together the
+// rows of the vertices in the BFS frontier
+static setword short_path_ball(graph *g, int v, int max_path_len)
+{
+    setword ball = bit[v];
+    setword frontier = bit[v];
+    for (int k=0; k<max_path_len && frontier; k++) {
+        setword next = 0;
+        while (frontier) {
+            int w;
+            TAKEBIT(w, frontier);
+            next |= g[w];
+        }
+        frontier = next & ~ball;
+        ball |= frontier;
+    }
+    return ball;
+}
+
+void all_pairs_check_for_short_path_frontier(graph *g, int n, int max_path_len, setword *have_short_path)
+{
+    for (int i=0; i<n; i++)
+        have_short_path[i] = short_path_ball(g, i, max_path_len);
+}
+
+#ifdef __AVX2__
+
+// As short_path_ball, but for the four source vertices v, v+1, v+2, v+3 at
+// once, one per 64-bit lane.  The first step just loads the four rows.  In
+// each later step, every vertex w is tested against all four frontiers at
+// once, and its row is OR-ed into the lanes whose frontier contains w.
+static void short_path_balls_x4(graph *g, int n, int v, int max_path_len, setword *have_short_path)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i self = _mm256_set_epi64x(bit[v+3], bit[v+2], bit[v+1], bit[v]);
+    __m256i frontier = _mm256_loadu_si256((__m256i *) &g[v]);
+    __m256i ball = _mm256_or_si256(self, frontier);
+    for (int k=1; k<max_path_len; k++) {
+        __m256i next = zero;
+        __m256i bit_w = _mm256_set1_epi64x(bit[0]);
+        for (int w=0; w<n; w++) {
+            __m256i lane_lacks_w = _mm256_cmpeq_epi64(_mm256_and_si256(frontier, bit_w), zero);
+            next = _mm256_or_si256(next, _mm256_andnot_si256(lane_lacks_w, _mm256_set1_epi64x(g[w])));
+            bit_w = _mm256_srli_epi64(bit_w, 1);
+        }
+        frontier = _mm256_andnot_si256(ball, next);
+        ball = _mm256_or_si256(ball, frontier);
+        if (_mm256_testz_si256(frontier, frontier))
+            break;
+    }
+    _mm256_storeu_si256((__m256i *) &have_short_path[v], ball);
+}
+
+// As short_path_balls_x4, for the eight source vertices v, ..., v+7, sharing
+// the broadcasts of each row between two vectors
+static void short_path_balls_x8(graph *g, int n, int v, int max_path_len, setword *have_short_path)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i self0 = _mm256_set_epi64x(bit[v+3], bit[v+2], bit[v+1], bit[v]);
+    __m256i self1 = _mm256_set_epi64x(bit[v+7], bit[v+6], bit[v+5], bit[v+4]);
+    __m256i frontier0 = _mm256_loadu_si256((__m256i *) &g[v]);
+    __m256i frontier1 = _mm256_loadu_si256((__m256i *) &g[v+4]);
+    __m256i ball0 = _mm256_or_si256(self0, frontier0);
+    __m256i ball1 = _mm256_or_si256(self1, frontier1);
+    for (int k=1; k<max_path_len; k++) {
+        __m256i next0 = zero;
+        __m256i next1 = zero;
+        __m256i bit_w = _mm256_set1_epi64x(bit[0]);
+        for (int w=0; w<n; w++) {
+            __m256i g_w = _mm256_set1_epi64x(g[w]);
+            __m256i lane_lacks_w0 = _mm256_cmpeq_epi64(_mm256_and_si256(frontier0, bit_w), zero);
+            __m256i lane_lacks_w1 = _mm256_cmpeq_epi64(_mm256_and_si256(frontier1, bit_w), zero);
+            next0 = _mm256_or_si256(next0, _mm256_andnot_si256(lane_lacks_w0, g_w));
+            next1 = _mm256_or_si256(next1, _mm256_andnot_si256(lane_lacks_w1, g_w));
+            bit_w = _mm256_srli_epi64(bit_w, 1);
+        }
+        frontier0 = _mm256_andnot_si256(ball0, next0);
+        frontier1 = _mm256_andnot_si256(ball1, next1);
+        ball0 = _mm256_or_si256(ball0, frontier0);
+        ball1 = _mm256_or_si256(ball1, frontier1);
+        __m256i frontier_union = _mm256_or_si256(frontier0, frontier1);
+        if (_mm256_testz_si256(frontier_union, frontier_union))
+            break;
+    }
+    _mm256_storeu_si256((__m256i *) &have_short_path[v], ball0);
+    _mm256_storeu_si256((__m256i *) &have_short_path[v+4], ball1);
+}
+
+void all_pairs_check_for_short_path_avx2(graph *g, int n, int max_path_len, setword *have_short_path)
+{
+    int i = 0;
+    for ( ; i+8<=n; i+=8)
+        short_path_balls_x8(g, n, i, max_path_len, have_short_path);
+    for ( ; i+4<=n; i+=4)
+        short_path_balls_x4(g, n, i, max_path_len, have_short_path);
+    for ( ; i<n; i++)
+        have_short_path[i] = short_path_ball(g, i, max_path_len);
+}
+
+#endif
+
+// Which pairs of vertices have a path of length max_path_len or less?
+void all_pairs_check_for_short_path(graph *g, int n, int max_path_len, setword *have_short_path)
+{
+#ifdef __AVX2__
+    all_pairs_check_for_short_path_avx2(g, n, max_path_len, have_short_path);
+#else
+    all_pairs_check_for_short_path_frontier(g, n, max_path_len, have_short_path);
+#endif
+}
+
+bool opposite_colour_arr(graph *g, int n, setword *opposite_colour)
+{
+    setword uncoloured = ALLMASK(n);
+    while (uncoloured) {
+        // 2-colour the component of the first uncoloured vertex
+        int v = FIRSTBITNZ(uncoloured);
+        setword colour[2] = {bit[v], 0};
+        setword frontier = bit[v];
+        int c = 0;
+        while (frontier) {
+            setword next = 0;
+            while (frontier) {
+                int w;
+                TAKEBIT(w, frontier);
+                next |= g[w];
+            }
+            if (next & colour[c])
+                return false;
+            c = !c;
+            frontier = next & ~colour[c];
+            colour[c] |= frontier;
+        }
+        uncoloured &= ~(colour[0] | colour[1]);
+        for (int c=0; c<2; c++) {
+            setword vv = colour[c];
+            while (vv) {
+                int w;
+                TAKEBIT(w, vv);
+                opposite_colour[w] = colour[!c];
+            }
+        }
+    }
+    return true;
+}
+
 void extend_short_path_arr(graph *g, int n, int max_path_len, setword *have_short_path,
         setword *parent_have_short_path)
 {
@@ -148,20 +300,68 @@ void extend_short_path_arr(graph *g, int n, int max_path_len, setword *have_shor
             have_short_path[v] |= bit[n-1];
         }
     } else {
-        all_pairs_check_for_short_path(g, n, max_path_len, have_short_path);
+        for (int i=0; i<n-1; i++)
+            have_short_path[i] = parent_have_short_path[i];
+        // layer[d] is the set of vertices at distance d from the new vertex,
+        // and within[d] is the union of layers 0 to d
+        setword layer[MAXN];
+        setword within[MAXN];
+        layer[0] = within[0] = bit[n-1];
+        for (int d=1; d<=max_path_len; d++) {
+            setword next = 0;
+            setword tmp = layer[d-1];
+            while (tmp) {
+                int v;
+                TAKEBIT(v, tmp);
+                next |= g[v];
+            }
+            layer[d] = next & ~within[d-1];
+            within[d] = within[d-1] | layer[d];
+        }
+        // A new short path from v to w goes through the new vertex
+        for (int d=1; d<=max_path_len; d++) {
+            setword tmp = layer[d];
+            while (tmp) {
+                int v;
+                TAKEBIT(v, tmp);
+                have_short_path[v] |= within[max_path_len - d];
+            }
+        }
+        have_short_path[n-1] = within[max_path_len];
+    }
+}
+
+// Relabel a short path array to match a relabelling of its graph in which
+// vertex lab[i] becomes vertex i (as returned by make_canonical)
+void relabel_short_path_arr(setword *have_short_path, int n, int *lab,
+        setword *relabelled_have_short_path)
+{
+    int lab_inv[MAXN];
+    for (int i=0; i<n; i++)
+        lab_inv[lab[i]] = i;
+
+    for (int i=0; i<n; i++) {
+        setword row = have_short_path[lab[i]];
+        setword new_row = 0;
+        while (row) {
+            int w;
+            TAKEBIT(w, row);
+            new_row |= bit[lab_inv[w]];
+        }
+        relabelled_have_short_path[i] = new_row;
     }
 }
 
-void show_graph(struct GraphPlus *gp)
+void show_graph(FILE *f, struct GraphPlus *gp)
 {
-    printf("Graph with %d vertices\n", gp->n);
+    fprintf(f, "Graph with %d vertices\n", gp->n);
     for (int i=0; i<gp->n; i++) {
         for (int j=0; j<gp->n; j++) {
-            printf("%s ", ISELEMENT(&gp->graph[i], j) ? "X" : ".");
+            fprintf(f, "%s ", ISELEMENT(&gp->graph[i], j) ? "X" : ".");
         }
-        printf("\n");
+        fprintf(f, "\n");
     }
-    printf("\n");
+    fprintf(f, "\n");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -367,7 +567,8 @@ int make_vv_sets(graph *g, int n, setword *vv_set)
     return current_set_num + 1;
 }
 
-void make_canonical(graph *g, int n, graph *canon_g)
+// Vertex lab[i] of g becomes vertex i of canon_g.  lab may be NULL.
+void make_canonical(graph *g, int n, graph *canon_g, int *lab)
 {
 #ifdef SELF_CONTAINED
     for (int i=0; i<n; i++) {
@@ -386,16 +587,22 @@ void make_canonical(graph *g, int n, graph *canon_g)
 
     for (int i=0; i<n; i++)
         canon_g[i] = incumbent_g[i];
+    if (lab)
+        for (int i=0; i<n; i++)
+            lab[i] = incumbent_order[i];
 
 #else
     static DEFAULTOPTIONS_GRAPH(options);
     options.getcanon = TRUE;
     options.tc_level = 0;
     static statsblk stats;
-    int lab[MAXN],ptn[MAXN],orbits[MAXN];
+    int nauty_lab[MAXN],ptn[MAXN],orbits[MAXN];
     EMPTYGRAPH(canon_g,1,MAXN);
     setword workspace[120];
-    nauty(g,lab,ptn,NULL,orbits,&options,&stats,workspace,120,1,n,canon_g);
+    nauty(g,nauty_lab,ptn,NULL,orbits,&options,&stats,workspace,120,1,n,canon_g);
+    if (lab)
+        for (int i=0; i<n; i++)
+            lab[i] = nauty_lab[i];
 #endif
 }
 
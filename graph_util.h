@@ -8,9 +8,25 @@ int num_neighbours_of_deg_d(graph *g, int v, int d, int *degs);
 
 void all_pairs_check_for_short_path(graph *g, int n, int max_path_len, setword *have_short_path);
 
+void all_pairs_check_for_short_path_pairwise(graph *g, int n, int max_path_len, setword *have_short_path);
+
+void all_pairs_check_for_short_path_frontier(graph *g, int n, int max_path_len, setword *have_short_path);
+
+#ifdef __AVX2__
+void all_pairs_check_for_short_path_avx2(graph *g, int n, int max_path_len, setword *have_short_path);
+#endif
+
+// If g is bipartite, sets opposite_colour[v] to the vertices of v's component
+// in the other colour class from v, that is, those at odd distance from v,
+// and returns true; otherwise returns false
+bool opposite_colour_arr(graph *g, int n, setword *opposite_colour);
+
 void extend_short_path_arr(graph *g, int n, int max_path_len, setword *have_short_path,
         setword *parent_have_short_path);
 
-void show_graph(struct GraphPlus *gp);
+void relabel_short_path_arr(setword *have_short_path, int n, int *lab,
+        setword *relabelled_have_short_path);
+
+void show_graph(FILE *f, struct GraphPlus *gp);
 
-void make_canonical(graph *g, int n, graph *canon_g);
+void make_canonical(graph *g, int n, graph *canon_g, int *lab);
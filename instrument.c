@@ -0,0 +1,170 @@
+#include "instrument.h"
+
+#ifdef INSTRUMENT
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+struct PhaseStats instr_phase_stats[MAXN+1][NUM_PHASES];
+unsigned long long instr_counters[MAXN+1][NUM_COUNTERS];
+struct InstrFrame instr_stack[INSTR_MAX_DEPTH];
+int instr_depth = 0;
+unsigned long long instr_last_time = 0;
+unsigned long long instr_tier_decisions[MAXN+1][INSTR_NUM_LEVELS][NUM_TIERS][2];
+enum DeletionTier instr_tier;
+int instr_num_events = 0;
+unsigned long long instr_last_events[INSTR_MAX_EVENTS];
+
+struct InstrEvent {
+    char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+static struct InstrEvent events[INSTR_MAX_EVENTS] = {
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"core_cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"l1d_read_misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+            (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+};
+
+// The events that were opened, in the order of the values read from the group
+static struct InstrEvent *open_events[INSTR_MAX_EVENTS];
+static int group_fd = -1;
+
+static char *phase_names[NUM_PHASES] = {
+    "visit",
+    "tentative_visit",
+    "output_graph",
+    "short_path_all_pairs",
+    "short_path_extend",
+    "deletion_nb_count_tier",
+    "deletion_modified_nds_tier",
+    "deletion_nds_tier",
+    "deletion_distance_profile_tier",
+    "deletion_nnds_tier",
+    "deletion_is_better",
+    "canon_deletion",
+    "canon_output",
+    "gp_set_add",
+    "write_graph"
+};
+
+static char *counter_names[NUM_COUNTERS] = {
+    "gp_set_new",
+    "gp_set_duplicate",
+    "lookahead_memo_hit"
+};
+
+static char *tier_names[NUM_TIERS] = {
+    "no_rivals",
+    "min_deg_nb_count",
+    "modified_nb_deg_sum",
+    "nb_deg_sum",
+    "weighted_nb_nb_deg_sum",
+    "distance_profile",
+    "degree_class_xor",
+    "tentative",
+    "nauty"
+};
+
+void instr_start()
+{
+    char *setting = getenv("INSTR_PERF");
+    if (setting && !strcmp(setting, "0"))
+        return;
+
+    for (int i=0; i<INSTR_MAX_EVENTS; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = group_fd == -1;
+        int fd = syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+        if (fd == -1) {
+            fprintf(stderr, "instrument: hardware counter %s is not available\n", events[i].name);
+            continue;
+        }
+        if (group_fd == -1)
+            group_fd = fd;
+        open_events[instr_num_events++] = &events[i];
+    }
+
+    if (instr_num_events) {
+        ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        instr_read_events(instr_last_events);
+    }
+}
+
+void instr_read_events(unsigned long long *values)
+{
+    // nr, time_enabled, time_running, then one value per event
+    uint64_t buf[3 + INSTR_MAX_EVENTS];
+    if (read(group_fd, buf, sizeof buf) < (ssize_t) ((3 + instr_num_events) * sizeof(uint64_t))) {
+        fprintf(stderr, "instrument: failed to read hardware counters\n");
+        exit(1);
+    }
+    for (int i=0; i<instr_num_events; i++)
+        values[i] = buf[3 + i];
+}
+
+// One line per (phase, order) with any calls, then one per (counter, order)
+// with a non-zero count.  Columns are tab-separated.  After a blank line
+// follows a second table of deletion_is_canonical decisions by tier, order
+// and tentativeness level.
+void instr_write_table(FILE *f)
+{
+    instr_charge();
+    if (instr_num_events) {
+        uint64_t buf[3 + INSTR_MAX_EVENTS];
+        if (read(group_fd, buf, sizeof buf) > 0 && buf[2] < buf[1])
+            fprintf(stderr, "instrument: hardware counters were multiplexed, and ran for "
+                    "%.1f%% of the time; their values are not scaled\n", 100.0 * buf[2] / buf[1]);
+    }
+
+    fprintf(f, "kind\tname\tn\tcalls\t%s", INSTR_TIME_UNIT);
+    for (int i=0; i<instr_num_events; i++)
+        fprintf(f, "\t%s", open_events[i]->name);
+    fprintf(f, "\n");
+    for (int p=0; p<NUM_PHASES; p++)
+        for (int n=0; n<=MAXN; n++) {
+            struct PhaseStats *ps = &instr_phase_stats[n][p];
+            if (ps->calls) {
+                fprintf(f, "phase\t%s\t%d\t%llu\t%llu", phase_names[p], n, ps->calls, ps->time);
+                for (int i=0; i<instr_num_events; i++)
+                    fprintf(f, "\t%llu", ps->events[i]);
+                fprintf(f, "\n");
+            }
+        }
+    for (int c=0; c<NUM_COUNTERS; c++)
+        for (int n=0; n<=MAXN; n++)
+            if (instr_counters[n][c]) {
+                fprintf(f, "counter\t%s\t%d\t%llu\t0", counter_names[c], n, instr_counters[n][c]);
+                for (int i=0; i<instr_num_events; i++)
+                    fprintf(f, "\t0");
+                fprintf(f, "\n");
+            }
+
+    fprintf(f, "\ntier\tn\ttentativeness\trejected\taccepted\n");
+    for (int t=0; t<NUM_TIERS; t++)
+        for (int n=0; n<=MAXN; n++)
+            for (int level=0; level<INSTR_NUM_LEVELS; level++) {
+                unsigned long long *d = instr_tier_decisions[n][level][t];
+                if (d[0] || d[1])
+                    fprintf(f, "%s\t%d\t%d\t%llu\t%llu\n", tier_names[t], n, level, d[0], d[1]);
+            }
+}
+
+#endif
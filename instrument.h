@@ -0,0 +1,200 @@
+// Optional instrumentation of the search, compiled in with -DINSTRUMENT
+// (see the ex_max_canonical_deletions_instrumented target in the Makefile).
+//
+// The time spent in each phase is measured with rdtsc (or clock_gettime on
+// other architectures), split by the order of the graph being worked on.
+// Phases nest: the time charged to a phase excludes the time spent in the
+// phases that it calls, so the total over all phases is the run time.
+//
+// Hardware counters (instructions, cycles, cache and branch misses) are also
+// opened with perf_event_open, if the kernel allows it, and attributed to
+// phases in the same way.  Reading them costs a system call at each change
+// of phase, which inflates the times; set INSTR_PERF=0 in the environment to
+// turn them off.
+//
+// Without INSTRUMENT, all of the macros below expand to nothing.
+
+#include <stdio.h>
+
+enum Phase {
+    PHASE_VISIT,                  // visit_graph and search at tentativeness level 0
+    PHASE_TENTATIVE_VISIT,        // visit_graph and search at higher levels
+    PHASE_OUTPUT_GRAPH,           // output_graph, apart from the phases it calls
+    PHASE_SHORT_PATH_ALL_PAIRS,   // all_pairs_check_for_short_path
+    PHASE_SHORT_PATH_EXTEND,      // extend_short_path_arr and relabel_short_path_arr
+    PHASE_DELETION_NB_COUNT_TIER, // deletion_is_canonical, number of neighbours of min degree
+    PHASE_DELETION_MODIFIED_NDS_TIER,  // deletion_is_canonical, modified_nb_deg_sum
+    PHASE_DELETION_NDS_TIER,      // deletion_is_canonical, nb_deg_sum_self_contained
+    PHASE_DELETION_DISTANCE_PROFILE_TIER,  // deletion_is_canonical, distance profile
+    PHASE_DELETION_NNDS_TIER,     // deletion_is_canonical, weighted_nb_nb_deg_sum
+    PHASE_DELETION_IS_BETTER,     // deletion_is_better, apart from make_canonical
+    PHASE_CANON_DELETION,         // make_canonical, called from deletion_is_better
+    PHASE_CANON_OUTPUT,           // make_canonical, called from output_graph
+    PHASE_GP_SET_ADD,             // gp_set_add
+    PHASE_WRITE_GRAPH,            // write_graph
+    NUM_PHASES
+};
+
+enum Counter {
+    COUNTER_GP_SET_NEW,           // gp_set_add calls that added a graph
+    COUNTER_GP_SET_DUPLICATE,     // gp_set_add calls for a graph already in the set
+    COUNTER_LOOKAHEAD_MEMO_HIT,   // extensions skipped by a LookaheadMemo
+    NUM_COUNTERS
+};
+
+// The tiers of tests used by deletion_is_canonical, cheapest first.  A
+// decision is attributed to the most expensive tier that had to be consulted
+// to reach it.
+enum DeletionTier {
+    TIER_NO_RIVALS,               // the last vertex is the only one of min degree
+    TIER_MIN_DEG_NB_COUNT,        // number of neighbours of min degree
+    TIER_MODIFIED_NB_DEG_SUM,     // modified_nb_deg_sum
+    TIER_NB_DEG_SUM,              // nb_deg_sum_self_contained
+    TIER_WEIGHTED_NB_NB_DEG_SUM,  // weighted_nb_nb_deg_sum
+    TIER_DISTANCE_PROFILE,        // distance profile, for regular graphs in regular mode
+    TIER_DEGREE_CLASS_XOR,        // degree-class XOR test in deletion_is_better
+    TIER_TENTATIVE,               // undecided by the XOR test, tentativeness level > 0
+    TIER_NAUTY,                   // make_canonical in deletion_is_better
+    NUM_TIERS
+};
+
+#ifdef INSTRUMENT
+
+#include "graph_plus.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline unsigned long long instr_now() { return __rdtsc(); }
+#define INSTR_TIME_UNIT "cycles"
+#else
+#include <time.h>
+static inline unsigned long long instr_now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+#define INSTR_TIME_UNIT "ns"
+#endif
+
+#define INSTR_MAX_DEPTH 4096
+// Number of tentativeness levels for which tier decisions are recorded
+#define INSTR_NUM_LEVELS 8
+
+// The most hardware counters that are read
+#define INSTR_MAX_EVENTS 5
+
+struct PhaseStats {
+    unsigned long long calls;
+    unsigned long long time;
+    unsigned long long events[INSTR_MAX_EVENTS];
+};
+
+struct InstrFrame {
+    enum Phase phase;
+    int n;
+};
+
+extern struct PhaseStats instr_phase_stats[MAXN+1][NUM_PHASES];
+extern unsigned long long instr_counters[MAXN+1][NUM_COUNTERS];
+extern struct InstrFrame instr_stack[INSTR_MAX_DEPTH];
+extern int instr_depth;
+extern unsigned long long instr_last_time;
+extern unsigned long long instr_tier_decisions[MAXN+1][INSTR_NUM_LEVELS][NUM_TIERS][2];
+extern enum DeletionTier instr_tier;
+extern int instr_num_events;
+extern unsigned long long instr_last_events[INSTR_MAX_EVENTS];
+
+// Reads the hardware counters into values
+void instr_read_events(unsigned long long *values);
+
+// Charges the time since the last event to the phase on top of the stack
+static inline void instr_charge()
+{
+    unsigned long long now = instr_now();
+    if (instr_depth > 0) {
+        struct InstrFrame *top = &instr_stack[instr_depth-1];
+        instr_phase_stats[top->n][top->phase].time += now - instr_last_time;
+    }
+    instr_last_time = now;
+    if (instr_num_events) {
+        unsigned long long values[INSTR_MAX_EVENTS];
+        instr_read_events(values);
+        if (instr_depth > 0) {
+            struct InstrFrame *top = &instr_stack[instr_depth-1];
+            for (int i=0; i<instr_num_events; i++)
+                instr_phase_stats[top->n][top->phase].events[i] += values[i] - instr_last_events[i];
+        }
+        for (int i=0; i<instr_num_events; i++)
+            instr_last_events[i] = values[i];
+    }
+}
+
+static inline int instr_enter(enum Phase phase, int n)
+{
+    instr_charge();
+    instr_stack[instr_depth++] = (struct InstrFrame) {phase, n};
+    instr_phase_stats[n][phase].calls++;
+    return 0;
+}
+
+static inline void instr_leave()
+{
+    instr_charge();
+    instr_depth--;
+}
+
+// Replaces the phase on top of the stack
+static inline void instr_switch(enum Phase phase)
+{
+    instr_charge();
+    struct InstrFrame *top = &instr_stack[instr_depth-1];
+    top->phase = phase;
+    instr_phase_stats[top->n][phase].calls++;
+}
+
+static inline void instr_leave_scope(int *unused)
+{
+    instr_leave();
+}
+
+// Opens the hardware counters, printing a note to stderr about any that
+// aren't available
+void instr_start();
+
+// Writes the table of phase and counter statistics
+void instr_write_table(FILE *f);
+
+#define INSTR_ENTER(phase, n) instr_enter(phase, n)
+#define INSTR_LEAVE() instr_leave()
+#define INSTR_SWITCH(phase) instr_switch(phase)
+#define INSTR_COUNT(counter, n) (instr_counters[n][counter]++)
+// Enters a phase that is left automatically when the enclosing block ends,
+// whichever return statement is taken
+#define INSTR_SCOPE(phase, n) \
+    __attribute__((cleanup(instr_leave_scope))) int instr_scope_ = instr_enter(phase, n); \
+    (void) instr_scope_
+// Notes that a test in the given tier has been consulted
+#define INSTR_TIER_REACHED(tier) \
+    (instr_tier = instr_tier > (tier) ? instr_tier : (tier))
+#define INSTR_TIER_RESET() (instr_tier = TIER_NO_RIVALS)
+// Records the decision of deletion_is_canonical
+#define INSTR_TIER_DECISION(n, tentativeness_level, accepted) \
+    (instr_tier_decisions[n][tentativeness_level][instr_tier][accepted]++)
+#define INSTR_START() instr_start()
+#define INSTR_WRITE_TABLE(f) instr_write_table(f)
+
+#else
+
+#define INSTR_ENTER(phase, n)
+#define INSTR_LEAVE()
+#define INSTR_SWITCH(phase)
+#define INSTR_COUNT(counter, n)
+#define INSTR_SCOPE(phase, n)
+#define INSTR_TIER_REACHED(tier)
+#define INSTR_TIER_RESET()
+#define INSTR_TIER_DECISION(n, tentativeness_level, accepted)
+#define INSTR_START()
+#define INSTR_WRITE_TABLE(f)
+
+#endif
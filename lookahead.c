@@ -0,0 +1,116 @@
+#include "graph_plus.h"
+#include "lookahead.h"
+#include "search.h"
+
+int lookahead_depth[MAXN+1];
+unsigned long long lookahead_work = 0;
+bool lookahead_is_adaptive = false;
+
+enum Action {SETTLE, PROBE, KEEP, REVERT};
+
+static char *action_names[] = {"settle", "probe", "keep", "revert"};
+
+// The state of the adaptation for the children of one order
+struct OrderState {
+    // The current window
+    unsigned long long lookaheads;
+    unsigned long long eliminated;
+    unsigned long long work;
+    long long windows;
+    // The depth chosen, and how it scored in the last window that used it
+    int best_depth;
+    double best_score;
+    bool probing;               // the current window uses another depth
+    int direction;              // of the next probe, +1 or -1
+    int settled_windows;        // at the chosen depth since the last probe
+};
+
+static struct OrderState states[MAXN+1];
+static int max_lookahead_depth = DEFAULT_LOOKAHEAD_DEPTH;
+static int fixed_order;
+static FILE *log_file = NULL;
+
+void set_lookahead(int max_depth, bool adaptive, FILE *log)
+{
+    max_lookahead_depth = max_depth;
+    lookahead_is_adaptive = adaptive;
+    log_file = log;
+    if (log_file)
+        fprintf(log_file, "# order window depth lookaheads eliminated work score action new_depth\n");
+}
+
+void start_lookahead(int fixed_up_to_order)
+{
+    fixed_order = fixed_up_to_order;
+    // Adaptive mode starts from the default depth, and tries deeper first
+    int start_depth = max_lookahead_depth;
+    if (lookahead_is_adaptive && start_depth > DEFAULT_LOOKAHEAD_DEPTH)
+        start_depth = DEFAULT_LOOKAHEAD_DEPTH;
+    for (int i=0; i<=MAXN; i++) {
+        lookahead_depth[i] = start_depth;
+        states[i] = (struct OrderState) {.best_depth=start_depth,
+                .direction=start_depth < max_lookahead_depth ? 1 : -1};
+    }
+}
+
+// Chooses the depth for the next window of s, given the score of the one
+// that has just finished
+static enum Action adapt(struct OrderState *s, int *depth, double score)
+{
+    if (s->probing) {
+        s->probing = false;
+        s->settled_windows = 0;
+        if (score > s->best_score) {
+            s->best_depth = *depth;
+            s->best_score = score;
+            return KEEP;
+        }
+        *depth = s->best_depth;
+        s->direction = -s->direction;
+        return REVERT;
+    }
+    s->best_score = score;
+    if (++s->settled_windows < LOOKAHEAD_SETTLE_WINDOWS || max_lookahead_depth == 0)
+        return SETTLE;
+    int next = *depth + s->direction;
+    if (next < 0 || next > max_lookahead_depth) {
+        s->direction = -s->direction;
+        next = *depth + s->direction;
+    }
+    s->probing = true;
+    *depth = next;
+    return PROBE;
+}
+
+void lookahead_record(int order, bool eliminated, unsigned long long work)
+{
+    if (order <= fixed_order)
+        return;
+    struct OrderState *s = &states[order];
+    s->lookaheads++;
+    s->eliminated += eliminated;
+    s->work += work;
+    if (s->lookaheads < LOOKAHEAD_WINDOW)
+        return;
+
+    double score = ((double) s->eliminated * LOOKAHEAD_ELIMINATION_VALUE - (double) s->work) /
+            s->lookaheads;
+    int old_depth = lookahead_depth[order];
+    enum Action action = adapt(s, &lookahead_depth[order], score);
+    if (log_file)
+        fprintf(log_file, "%d %lld %d %llu %llu %llu %.3f %s %d\n", order, s->windows, old_depth,
+                s->lookaheads, s->eliminated, s->work, score, action_names[action],
+                lookahead_depth[order]);
+    s->windows++;
+    s->lookaheads = 0;
+    s->eliminated = 0;
+    s->work = 0;
+}
+
+void print_lookahead_depths(FILE *f)
+{
+    fprintf(f, "lookahead depth");
+    for (int i=0; i<global_n; i++)
+        fprintf(f, " %d", lookahead_depth[i]);
+    fprintf(f, "\n");
+}
@@ -0,0 +1,64 @@
+#include <stdbool.h>
+#include <stdio.h>
+
+// The depth of the tentative lookahead from each child found at
+// tentativeness level 0.  At depth 1, the child is only kept if it passes
+// the cheap tests of visit_graph; at each further depth, it must also have
+// an extension by one more vertex that passes them.  Depth 0 keeps every
+// child.
+//
+// By default, the children of every order get the same depth.  In adaptive
+// mode, the depth for each order is adjusted between 0 and the maximum as
+// the search goes.  For each window of lookaheads from children of an
+// order, the search scores the depth by the graphs visited by the lookahead
+// (its cost) against the children it eliminated, each of which would
+// otherwise have been canonicalised and visited at level 0.  From time to
+// time it tries the next depth up or down for a window, and keeps it if it
+// scores better.  The measures are counts, not times, so a search makes the
+// same decisions each time it is run.
+//
+// The log written in adaptive mode has a line for each window:
+//     order window depth lookaheads eliminated work score action new_depth
+// where work is the number of graphs the lookaheads visited, score is
+// (eliminated * LOOKAHEAD_ELIMINATION_VALUE - work) / lookaheads, and action
+// is one of settle, probe, keep or revert.
+
+#define DEFAULT_LOOKAHEAD_DEPTH 3
+
+#define MAX_LOOKAHEAD_DEPTH 7
+
+// Lookaheads in a window
+#define LOOKAHEAD_WINDOW 2048
+
+// Windows between probes of another depth
+#define LOOKAHEAD_SETTLE_WINDOWS 4
+
+// The estimated cost of keeping a child that the lookahead would have
+// eliminated, in graphs visited by the lookahead
+#define LOOKAHEAD_ELIMINATION_VALUE 16
+
+// The lookahead depth for children of each order
+extern int lookahead_depth[MAXN+1];
+
+// Graphs visited above tentativeness level 0, counted by the search
+extern unsigned long long lookahead_work;
+
+// Sets the lookahead depth, which is DEFAULT_LOOKAHEAD_DEPTH by default,
+// and whether it is adapted; in adaptive mode, the decisions are written to
+// log if it is not NULL.  Call before start_search.
+void set_lookahead(int max_depth, bool adaptive, FILE *log);
+
+// Called by start_search: sets the lookahead depth for children of every
+// order to the maximum or, in adaptive mode, to DEFAULT_LOOKAHEAD_DEPTH if
+// that is less.  In adaptive mode, only the depths for orders above
+// fixed_up_to_order are then adjusted (see search_iter_start_full).
+void start_lookahead(int fixed_up_to_order);
+
+extern bool lookahead_is_adaptive;
+
+// In adaptive mode, records a lookahead from a child of the given order:
+// whether it eliminated the child, and how many graphs it visited
+void lookahead_record(int order, bool eliminated, unsigned long long work);
+
+// Writes "lookahead depth" and the final depth for each order below global_n to f
+void print_lookahead_depths(FILE *f);
@@ -0,0 +1,75 @@
+// Merges binary containers written with `-f binary` by the shards of one
+// search (for example, by run_experiment) into a single container.  The
+// index of the result records which graphs came from which shard.
+//
+// Usage: ./merge_containers OUTPUT_FILE INPUT_FILE...
+
+#include "graph_plus.h"
+#include "graph_container.h"
+#include "util.h"
+
+#include <string.h>
+
+static void write_or_die(void *buf, size_t size, FILE *f)
+{
+    if (size && fwrite(buf, size, 1, f) != 1) {
+        fprintf(stderr, "Failed to write merged container\n");
+        exit(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        printf("Required: output file, one or more input files.\n");
+        exit(1);
+    }
+
+    int num_inputs = argc - 2;
+    struct Container *inputs = emalloc(num_inputs * sizeof(struct Container));
+    for (int i=0; i<num_inputs; i++)
+        if (!container_open(argv[i+2], &inputs[i]))
+            exit(1);
+
+    struct ContainerHeader header = *inputs[0].header;
+    header.shard_id = CONTAINER_MERGED;
+    header.num_shards = 0;
+    header.graph_count = 0;
+    for (int i=0; i<num_inputs; i++) {
+        struct ContainerHeader *h = inputs[i].header;
+        if (h->min_girth != header.min_girth || h->n != header.n || h->edge_count != header.edge_count) {
+            fprintf(stderr, "%s is from a different search than %s\n", argv[i+2], argv[2]);
+            exit(1);
+        }
+        header.num_shards += h->num_shards;
+        header.graph_count += h->graph_count;
+    }
+    header.index_offset = sizeof header + header.graph_count * header.n * sizeof(uint64_t);
+
+    FILE *f = fopen(argv[1], "w");
+    if (!f) {
+        fprintf(stderr, "Can't open %s for writing\n", argv[1]);
+        exit(1);
+    }
+    write_or_die(&header, sizeof header, f);
+    for (int i=0; i<num_inputs; i++)
+        write_or_die(inputs[i].graphs, inputs[i].header->graph_count * header.n * sizeof(uint64_t), f);
+
+    uint64_t first_graph = 0;
+    for (int i=0; i<num_inputs; i++) {
+        for (uint32_t j=0; j<inputs[i].header->num_shards; j++) {
+            struct ContainerIndexEntry entry = inputs[i].index[j];
+            entry.first_graph += first_graph;
+            write_or_die(&entry, sizeof entry, f);
+        }
+        first_graph += inputs[i].header->graph_count;
+    }
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "Failed to write merged container\n");
+        exit(1);
+    }
+    for (int i=0; i<num_inputs; i++)
+        container_close(&inputs[i]);
+    free(inputs);
+}
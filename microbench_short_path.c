@@ -0,0 +1,117 @@
+// Micro-benchmark for the all-pairs short path kernels.
+//
+// Reads graphs in the format written by show_graph (for example, the output
+// of ex_max_canonical_deletions) from stdin, checks that every kernel gives
+// the same result as the original pairwise version, and reports the time
+// per graph for each kernel.
+//
+// Usage: ./ex_max_canonical_deletions 5 20 38 | ./microbench_short_path 5 [reps]
+
+#include "graph_plus.h"
+#include "graph_util.h"
+#include "util.h"
+
+#include <string.h>
+#include <time.h>
+
+#define MAX_GRAPHS (1 << 16)
+
+struct Kernel {
+    char *name;
+    void (*fun)(graph *g, int n, int max_path_len, setword *have_short_path);
+};
+
+static struct Kernel kernels[] = {
+    {"pairwise", all_pairs_check_for_short_path_pairwise},
+    {"frontier", all_pairs_check_for_short_path_frontier},
+#ifdef __AVX2__
+    {"frontier_avx2", all_pairs_check_for_short_path_avx2},
+#endif
+};
+
+static int read_graphs(struct GraphPlus *graphs, int max_graphs)
+{
+    char line[1024];
+    int num_graphs = 0;
+    while (num_graphs < max_graphs && fgets(line, sizeof line, stdin)) {
+        int n;
+        if (sscanf(line, "Graph with %d vertices", &n) != 1)
+            continue;
+        graph g[MAXN] = {};
+        for (int i=0; i<n; i++) {
+            if (!fgets(line, sizeof line, stdin)) {
+                fprintf(stderr, "Unexpected end of input\n");
+                exit(1);
+            }
+            int j = 0;
+            for (char *c=line; *c && j<n; c++) {
+                if (*c == 'X')
+                    ADDELEMENT(&g[i], j);
+                if (*c == 'X' || *c == '.')
+                    j++;
+            }
+        }
+        int edge_count = 0;
+        for (int i=0; i<n; i++)
+            edge_count += POPCOUNT(g[i]);
+        make_graph_plus(g, n, edge_count / 2, 0, 0, &graphs[num_graphs++]);
+    }
+    return num_graphs;
+}
+
+static double elapsed_seconds(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        printf("Required: min girth.  Optional: number of repetitions.\n");
+        exit(1);
+    }
+    int max_path_len = atoi(argv[1]) - 3;
+    int reps = argc > 2 ? atoi(argv[2]) : 100;
+
+    struct GraphPlus *graphs = emalloc(MAX_GRAPHS * sizeof(struct GraphPlus));
+    int num_graphs = read_graphs(graphs, MAX_GRAPHS);
+    if (num_graphs == 0) {
+        printf("No graphs read.\n");
+        exit(1);
+    }
+    printf("%d graphs, max path length %d, %d repetitions\n", num_graphs, max_path_len, reps);
+
+    int num_kernels = sizeof kernels / sizeof kernels[0];
+    for (int i=0; i<num_graphs; i++) {
+        setword expected[MAXN];
+        kernels[0].fun(graphs[i].graph, graphs[i].n, max_path_len, expected);
+        for (int k=1; k<num_kernels; k++) {
+            setword actual[MAXN];
+            kernels[k].fun(graphs[i].graph, graphs[i].n, max_path_len, actual);
+            if (memcmp(expected, actual, graphs[i].n * sizeof(setword))) {
+                printf("Kernel %s disagrees with %s on graph %d\n", kernels[k].name, kernels[0].name, i);
+                exit(1);
+            }
+        }
+    }
+
+    setword checksum = 0;
+    for (int k=0; k<num_kernels; k++) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int r=0; r<reps; r++) {
+            for (int i=0; i<num_graphs; i++) {
+                setword have_short_path[MAXN];
+                kernels[k].fun(graphs[i].graph, graphs[i].n, max_path_len, have_short_path);
+                checksum += have_short_path[i % graphs[i].n];
+            }
+        }
+        double secs = elapsed_seconds(&start);
+        printf("%-16s %10.1f ns/graph\n", kernels[k].name, secs * 1e9 / ((double) reps * num_graphs));
+    }
+    printf("checksum %llu\n", (unsigned long long) checksum);
+
+    free(graphs);
+}
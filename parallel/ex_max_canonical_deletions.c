@@ -12,6 +12,7 @@
 #include <stdbool.h>
 #include <stdatomic.h>
 #include <pthread.h>
+#include <getopt.h>
 
 #define SPLITTING_ORDER 20
 
@@ -26,6 +27,11 @@ int global_num_threads = 8;
 
 static _Atomic(unsigned long long) global_graph_count = ATOMIC_VAR_INIT(0ULL);
 
+// In existence-only mode, the first thread to find a graph of order global_n
+// sets global_search_stopped, and all threads then stop
+static bool global_first_only = false;
+static atomic_bool global_search_stopped = ATOMIC_VAR_INIT(false);
+
 #define MAX_GRAPHLIST_LEN (1 << 17)
 struct GraphList {
     int count;
@@ -227,7 +233,7 @@ void search(struct GraphPlus *gp, setword *have_short_path,
     if (neighbours_count == gp->min_deg + 1)
         return;
 
-    while (candidate_neighbours) {
+    while (candidate_neighbours && !atomic_load(&global_search_stopped)) {
         int cand;
         TAKEBIT(cand, candidate_neighbours);
         ADDELEMENT(&neighbours, cand);
@@ -253,7 +259,7 @@ void visit_graph(struct GraphPlus *gp);
 void * visit_splitting_graphs_one_thread(void *arg)
 {
     struct GraphPlus gp;
-    while (graph_list_take(&splitting_graphs, &gp))
+    while (!atomic_load(&global_search_stopped) && graph_list_take(&splitting_graphs, &gp))
         visit_graph(&gp);
     return NULL;
 }
@@ -273,8 +279,13 @@ void visit_splitting_graphs_all_threads()
 
 void visit_graph(struct GraphPlus *gp)
 {
+    if (atomic_load(&global_search_stopped))
+        return;
+
     if (gp->n==global_n) {
         // output graph
+        if (global_first_only && atomic_exchange(&global_search_stopped, true))
+            return;    // another thread got there first
         global_graph_count++;
         graph_list_append_thread_safe(&extremal_graphs, gp);
     } else if (gp->n == SPLITTING_ORDER && !gp->in_graph_list) {
@@ -323,6 +334,25 @@ int main(int argc, char *argv[])
     options.getcanon = TRUE;
     options.tc_level = 0;
 
+    static struct option long_options[] = {
+        {"first", no_argument, NULL, '1'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (opt) {
+        case '1':
+            global_first_only = true;
+            break;
+        default:
+            printf("Usage: ex_max_canonical_deletions [--first] min_girth n edge_count [num_threads]\n");
+            exit(1);
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+
     if (argc < 4) {
         printf("Not enough arguments.\n");
         printf("Required: min girth, n, max edge count.\n");
@@ -371,6 +401,8 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (atomic_load(&global_search_stopped))
+        printf("Search stopped at the first graph found\n");
     printf("Total graph count: %llu\n", global_graph_count);
 
     clean_up_graph_type_lists();
@@ -160,10 +160,19 @@ static void make_possible_graph_types_recurse(int n, int edge_count, int min_deg
     }
 }
 
-void make_possible_graph_types(int n, int edge_count, int min_girth)
+void make_possible_graph_types(int n, int edge_count, int min_girth, setword allowed_degrees)
 {
+    // The graphs of order n are built from graphs with no greater maximum
+    // degree, so capping the maximum degree here caps it at every order
+    int max_deg_cap = MAX_DEG_UPPER_BOUND;
+    while (max_deg_cap > 0 && !(allowed_degrees & bit[max_deg_cap]))
+        max_deg_cap--;
     for (int min_deg=0; min_deg<=MIN_DEG_UPPER_BOUND; min_deg++) {
-        for (int max_deg=min_deg; max_deg<=MAX_DEG_UPPER_BOUND; max_deg++) {
+        if (!(allowed_degrees & bit[min_deg]))
+            continue;
+        for (int max_deg=min_deg; max_deg<=max_deg_cap; max_deg++) {
+            if (!(allowed_degrees & bit[max_deg]))
+                continue;
             if (min_and_max_deg_are_feasible(n, min_deg, max_deg, edge_count, min_girth)) {
                 make_possible_graph_types_recurse(n, edge_count, min_deg, max_deg, min_girth, 1);
             }
@@ -227,5 +236,6 @@ void clean_up_graph_type_lists()
             free(head);
             head = next;
         }
+        graph_type_list_heads[i] = NULL;
     }
 }
@@ -9,7 +9,10 @@ struct GraphType {
     setword lb_on_num_vv_of_min_deg_tried[MAXN];
 };
 
-void make_possible_graph_types(int n, int edge_count, int min_girth);
+// Finds the types of the graphs that the search may visit in making graphs
+// of order n.  The graphs of order n must have minimum and maximum degree
+// in allowed_degrees (a set of degrees, as a setword).
+void make_possible_graph_types(int n, int edge_count, int min_girth, setword allowed_degrees);
 
 struct GraphType * find_graph_type_in_set(struct GraphType *graph_type);
 
@@ -0,0 +1,142 @@
+#include "graph_plus.h"
+#include "extremal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Built-in predicates (see extremal.h)
+
+static int is_bipartite(const uint64_t *rows, int n, const char *arg)
+{
+    setword side[2] = {0, 0};
+    setword seen = 0;
+    setword unseen = ALLMASK(n);
+    while (unseen) {
+        int v;
+        TAKEBIT(v, unseen);
+        side[0] |= bit[v];
+        seen |= bit[v];
+        setword frontier = bit[v];
+        int s = 0;
+        while (frontier) {
+            setword nb = 0;
+            while (frontier) {
+                int w;
+                TAKEBIT(w, frontier);
+                nb |= rows[w];
+            }
+            if (nb & side[s])
+                return 0;
+            frontier = nb & ~seen;
+            side[1-s] |= frontier;
+            seen |= frontier;
+            s = 1 - s;
+        }
+        unseen &= ~seen;
+    }
+    return 1;
+}
+
+// The greatest distance from v, or -1 if some vertex can't be reached
+static int eccentricity(const uint64_t *rows, int n, int v)
+{
+    setword seen = bit[v];
+    setword frontier = bit[v];
+    int dist = 0;
+    for (;;) {
+        setword nb = 0;
+        while (frontier) {
+            int w;
+            TAKEBIT(w, frontier);
+            nb |= rows[w];
+        }
+        frontier = nb & ~seen;
+        if (!frontier)
+            break;
+        seen |= frontier;
+        dist++;
+    }
+    return seen == ALLMASK(n) ? dist : -1;
+}
+
+static int is_connected(const uint64_t *rows, int n, const char *arg)
+{
+    return eccentricity(rows, n, 0) != -1;
+}
+
+static int has_max_diameter(const uint64_t *rows, int n, const char *arg)
+{
+    int max_diameter = arg ? atoi(arg) : 0;
+    for (int v=0; v<n; v++) {
+        int ecc = eccentricity(rows, n, v);
+        if (ecc == -1 || ecc > max_diameter)
+            return 0;
+    }
+    return 1;
+}
+
+static int has_allowed_degrees(const uint64_t *rows, int n, const char *arg)
+{
+    // The argument is parsed once for each string it is given as
+    static const char *parsed_arg = NULL;
+    static setword allowed = 0;
+    if (arg != parsed_arg) {
+        allowed = 0;
+        for (const char *s=arg; s && *s; ) {
+            char *end;
+            long d = strtol(s, &end, 10);
+            if (end == s)
+                break;
+            if (d >= 0 && d < MAXN)
+                allowed |= bit[d];
+            s = *end == ',' ? end + 1 : end;
+        }
+        parsed_arg = arg;
+    }
+    for (int i=0; i<n; i++)
+        if (!(allowed & bit[POPCOUNT(rows[i])]))
+            return 0;
+    return 1;
+}
+
+static int has_min_automorphisms(const uint64_t *rows, int n, const char *arg)
+{
+    double min_size = arg ? atof(arg) : 1;
+    static DEFAULTOPTIONS_GRAPH(options);
+    static statsblk stats;
+    int lab[MAXN], ptn[MAXN], orbits[MAXN];
+    setword workspace[120];
+    graph g[MAXN];
+    for (int i=0; i<n; i++)
+        g[i] = rows[i];
+    nauty(g, lab, ptn, NULL, orbits, &options, &stats, workspace, 120, 1, n, NULL);
+    double size = stats.grpsize1;
+    for (int i=0; i<stats.grpsize2; i++)
+        size *= 10;
+    return size >= min_size;
+}
+
+static struct {
+    char *name;
+    ExtremalPredicate predicate;
+    bool is_hereditary;
+} builtin_predicates[] = {
+    {"bipartite", is_bipartite, true},
+    {"connected", is_connected, false},
+    {"max-diameter", has_max_diameter, false},
+    {"degrees", has_allowed_degrees, false},
+    {"min-automorphisms", has_min_automorphisms, false},
+};
+
+bool extremal_builtin_predicate(const char *name, ExtremalPredicate *predicate,
+        bool *is_hereditary)
+{
+    for (size_t i=0; i<sizeof builtin_predicates / sizeof builtin_predicates[0]; i++) {
+        if (!strcmp(name, builtin_predicates[i].name)) {
+            *predicate = builtin_predicates[i].predicate;
+            *is_hereditary = builtin_predicates[i].is_hereditary;
+            return true;
+        }
+    }
+    return false;
+}
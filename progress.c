@@ -0,0 +1,213 @@
+#include "graph_plus.h"
+#include "progress.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+volatile sig_atomic_t progress_requested = 0;
+
+static char *progress_filename = NULL;
+static int progress_n;
+static unsigned long long *progress_visited_by_order;
+static unsigned long long *progress_graph_count;
+static long long *progress_canonicalisation_calls;
+static struct timespec progress_start_time;
+
+// The graphs on the path from the root of the current subtree to the graph
+// currently being visited, indexed by order
+struct ProgressFrame {
+    unsigned long long start_nodes;   // node_count when the graph was entered
+    unsigned long long children;      // children that have been left
+    unsigned long long num_children;  // children found, if known
+};
+
+static struct ProgressFrame frames[MAXN+1];
+static int root_order = 0;            // of the current root, or 0 if none
+static int deepest_order = 0;
+static unsigned long long node_count = 0;
+
+// The roots searched: a search from order 1 has one, and a search from a
+// frontier has one for each graph of the frontier
+static unsigned long long num_roots = 1;
+static unsigned long long roots_done = 0;
+static unsigned long long root_nodes_done = 0;
+
+// Online statistics of the subtrees rooted at each order that have been left
+struct SubtreeStats {
+    unsigned long long subtrees;
+    unsigned long long nodes;
+};
+
+static struct SubtreeStats subtree_stats[MAXN+1];
+
+static void request_progress(int sig)
+{
+    progress_requested = 1;
+}
+
+void start_progress(int interval_seconds, char *status_filename, int n,
+        unsigned long long *visited_by_order, unsigned long long *graph_count,
+        long long *canonicalisation_calls)
+{
+    progress_filename = status_filename;
+    progress_n = n;
+    progress_visited_by_order = visited_by_order;
+    progress_graph_count = graph_count;
+    progress_canonicalisation_calls = canonicalisation_calls;
+    clock_gettime(CLOCK_MONOTONIC, &progress_start_time);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = request_progress;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+
+    if (interval_seconds > 0) {
+        sigaction(SIGALRM, &sa, NULL);
+        struct itimerval timer = {{interval_seconds, 0}, {interval_seconds, 0}};
+        setitimer(ITIMER_REAL, &timer, NULL);
+    }
+}
+
+static double elapsed_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - progress_start_time.tv_sec) +
+            (now.tv_nsec - progress_start_time.tv_nsec) / 1e9;
+}
+
+// Estimates the number of nodes in the subtree of the current root, working
+// up the current path from the deepest graph to the root (not to order 1, as
+// a search from a frontier starts higher).  The subtree of a graph on the
+// path consists of its completed children (whose sizes are known), the child
+// on the path (estimated recursively), and the children still to come, each
+// taken to have the mean subtree size of the order below.  The trees are very
+// skewed, so this is only a rough guide.
+static double estimate_root_size()
+{
+    if (root_order == 0)
+        return 0;
+    double child_size = 0;
+    for (int order=deepest_order; order>=root_order; order--) {
+        struct ProgressFrame *f = &frames[order];
+        bool on_path = order < deepest_order;
+        // The child on the path counts towards the mean with the nodes it has
+        // so far, since it is often much larger than the children that were
+        // completed quickly.  Counting it with its own estimate instead
+        // compounds the error at every order
+        double mean_child_size = 1;
+        if (order < MAXN) {
+            struct SubtreeStats *cs = &subtree_stats[order+1];
+            double subtrees = cs->subtrees + on_path;
+            double on_path_nodes = on_path ? node_count - frames[order+1].start_nodes : 0;
+            if (subtrees > 0)
+                mean_child_size = (cs->nodes + on_path_nodes) / subtrees;
+        }
+        double started_children = f->children + on_path;
+        double remaining = f->num_children > started_children ? f->num_children - started_children : 0;
+        double done = on_path ? frames[order+1].start_nodes - f->start_nodes
+                              : node_count - f->start_nodes;
+        child_size = done + (on_path ? child_size : 0) + remaining * mean_child_size;
+    }
+    return child_size;
+}
+
+// Estimates the number of nodes in the whole search: the roots that are
+// done, the current one, and those still to come, each taken to have the
+// mean size of the others
+static double estimate_tree_size()
+{
+    double current = estimate_root_size();
+    unsigned long long roots_started = roots_done + (root_order != 0);
+    if (roots_started == 0)
+        return 0;
+    double mean_root_size = (root_nodes_done + current) / roots_started;
+    double remaining = num_roots > roots_started ? num_roots - roots_started : 0;
+    return root_nodes_done + current + remaining * mean_root_size;
+}
+
+static void write_progress_to(FILE *f)
+{
+    double secs = elapsed_seconds();
+    fprintf(f, "elapsed %.1f s\n", secs);
+    fprintf(f, "visited");
+    for (int i=0; i<=progress_n; i++)
+        fprintf(f, " %llu", progress_visited_by_order[i]);
+    fprintf(f, "\n");
+    fprintf(f, "graphs found %llu\n", *progress_graph_count);
+    fprintf(f, "canonicalisation calls %lld (%.0f/s)\n", *progress_canonicalisation_calls,
+            secs > 0 ? *progress_canonicalisation_calls / secs : 0);
+    double tree_size = estimate_tree_size();
+    double fraction = tree_size > 0 ? node_count / tree_size : 0;
+    if (fraction > 1)
+        fraction = 1;
+    fprintf(f, "estimated fraction done %.6f\n", fraction);
+    if (fraction > 0)
+        fprintf(f, "estimated time remaining %.0f s\n", secs * (1 - fraction) / fraction);
+    else
+        fprintf(f, "estimated time remaining unknown\n");
+}
+
+void write_progress()
+{
+    progress_requested = 0;
+    if (!progress_filename) {
+        write_progress_to(stderr);
+        fprintf(stderr, "\n");
+        return;
+    }
+    // Write to a temporary file and rename it, so that readers of the status
+    // file never see a partial report
+    char tmp_filename[4096];
+    snprintf(tmp_filename, sizeof tmp_filename, "%s.tmp", progress_filename);
+    FILE *f = fopen(tmp_filename, "w");
+    if (!f) {
+        fprintf(stderr, "Can't open %s for writing\n", tmp_filename);
+        return;
+    }
+    write_progress_to(f);
+    fclose(f);
+    rename(tmp_filename, progress_filename);
+}
+
+void progress_set_roots(unsigned long long count)
+{
+    num_roots = count;
+}
+
+void progress_enter_subtree(int order)
+{
+    if (progress_requested)
+        write_progress();
+    if (root_order == 0)
+        root_order = order;
+    frames[order] = (struct ProgressFrame) {node_count, 0, 0};
+    deepest_order = order;
+    node_count++;
+}
+
+void progress_set_children(int order, unsigned long long count)
+{
+    frames[order].num_children = count;
+}
+
+void progress_leave_subtree(int order)
+{
+    unsigned long long nodes = node_count - frames[order].start_nodes;
+    struct SubtreeStats *s = &subtree_stats[order];
+    s->subtrees++;
+    s->nodes += nodes;
+    if (order > root_order) {
+        frames[order-1].children++;
+        deepest_order = order - 1;
+    } else {
+        roots_done++;
+        root_nodes_done += nodes;
+        root_order = 0;
+        deepest_order = 0;
+    }
+}
@@ -0,0 +1,37 @@
+#include <stdbool.h>
+#include <signal.h>
+
+// Progress reports for long searches.
+//
+// A report gives the number of graphs visited at each order, the number of
+// graphs found, the canonicalisation rate, and an estimate of the fraction
+// of the search tree that has been visited and of the time remaining.  It is
+// written every interval_seconds (if interval_seconds > 0) and whenever the
+// process receives SIGUSR1, to status_filename if that is not NULL
+// (replacing its contents) and otherwise to stderr.
+//
+// The counters are owned by the caller and are only read.
+void start_progress(int interval_seconds, char *status_filename, int n,
+        unsigned long long *visited_by_order, unsigned long long *graph_count,
+        long long *canonicalisation_calls);
+
+// Set by the signal handlers; a report is written at the next call of
+// progress_enter_subtree
+extern volatile sig_atomic_t progress_requested;
+
+void write_progress();
+
+// The number of roots that the search will visit, if it isn't 1 (for
+// example, the graphs of a frontier)
+void progress_set_roots(unsigned long long count);
+
+// These bracket each visit to a graph at tentativeness level 0, and are used
+// to estimate the size of the search tree.  A graph entered while none is on
+// the path is a root.
+void progress_enter_subtree(int order);
+
+void progress_leave_subtree(int order);
+
+// The number of children found for the graph of the given order on the
+// current path, once they are known, or after some have been given away
+void progress_set_children(int order, unsigned long long count);
@@ -0,0 +1,196 @@
+#include "protocol.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+void message_init(struct Message *m, enum MessageType type)
+{
+    m->type = type;
+    m->length = 0;
+    m->pos = 0;
+    m->overrun = false;
+}
+
+static void put_bytes(struct Message *m, void *bytes, size_t len)
+{
+    if (m->length + len > MAX_MESSAGE_LEN) {
+        fprintf(stderr, "Message too long\n");
+        exit(1);
+    }
+    memcpy(m->payload + m->length, bytes, len);
+    m->length += len;
+}
+
+static void encode_u32(unsigned char *buf, uint32_t x)
+{
+    for (int i=0; i<4; i++)
+        buf[i] = x >> (8 * i);
+}
+
+static uint32_t decode_u32(unsigned char *buf)
+{
+    uint32_t x = 0;
+    for (int i=0; i<4; i++)
+        x |= (uint32_t) buf[i] << (8 * i);
+    return x;
+}
+
+void put_u32(struct Message *m, uint32_t x)
+{
+    unsigned char buf[4];
+    encode_u32(buf, x);
+    put_bytes(m, buf, 4);
+}
+
+void put_u64(struct Message *m, uint64_t x)
+{
+    put_u32(m, x);
+    put_u32(m, x >> 32);
+}
+
+void put_string(struct Message *m, char *s)
+{
+    size_t len = strlen(s);
+    put_u32(m, len);
+    put_bytes(m, s, len);
+}
+
+static unsigned char *get_bytes(struct Message *m, size_t len)
+{
+    if (m->pos + len > m->length) {
+        m->overrun = true;
+        return NULL;
+    }
+    unsigned char *p = m->payload + m->pos;
+    m->pos += len;
+    return p;
+}
+
+uint32_t get_u32(struct Message *m)
+{
+    unsigned char *p = get_bytes(m, 4);
+    return p ? decode_u32(p) : 0;
+}
+
+uint64_t get_u64(struct Message *m)
+{
+    uint64_t lo = get_u32(m);
+    uint64_t hi = get_u32(m);
+    return lo | hi << 32;
+}
+
+void get_string(struct Message *m, char *s, size_t size)
+{
+    uint32_t len = get_u32(m);
+    unsigned char *p = get_bytes(m, len);
+    if (!p || len >= size) {
+        m->overrun = true;
+        s[0] = '\0';
+        return;
+    }
+    memcpy(s, p, len);
+    s[len] = '\0';
+}
+
+static bool write_all(int fd, unsigned char *buf, size_t len)
+{
+    while (len) {
+        ssize_t k = write(fd, buf, len);
+        if (k == -1 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return false;
+        buf += k;
+        len -= k;
+    }
+    return true;
+}
+
+static bool read_all(int fd, unsigned char *buf, size_t len)
+{
+    while (len) {
+        ssize_t k = read(fd, buf, len);
+        if (k == -1 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return false;
+        buf += k;
+        len -= k;
+    }
+    return true;
+}
+
+bool send_message(int fd, struct Message *m)
+{
+    unsigned char header[8];
+    encode_u32(header, m->type);
+    encode_u32(header + 4, m->length);
+    return write_all(fd, header, 8) && write_all(fd, m->payload, m->length);
+}
+
+bool recv_message(int fd, struct Message *m)
+{
+    unsigned char header[8];
+    if (!read_all(fd, header, 8))
+        return false;
+    m->type = decode_u32(header);
+    m->length = decode_u32(header + 4);
+    m->pos = 0;
+    m->overrun = false;
+    if (m->length > MAX_MESSAGE_LEN)
+        return false;
+    return read_all(fd, m->payload, m->length);
+}
+
+static bool make_address(char *path, struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof *addr);
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof addr->sun_path) {
+        fprintf(stderr, "Socket path %s is too long\n", path);
+        return false;
+    }
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+int listen_unix_socket(char *path)
+{
+    struct sockaddr_un addr;
+    if (!make_address(path, &addr))
+        return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof addr) == -1 || listen(fd, 64) == -1) {
+        fprintf(stderr, "Can't listen on %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connect_unix_socket(char *path, int timeout_seconds)
+{
+    struct sockaddr_un addr;
+    if (!make_address(path, &addr))
+        return -1;
+    for (int attempt=0; attempt<=timeout_seconds * 10; attempt++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1)
+            return -1;
+        if (connect(fd, (struct sockaddr *) &addr, sizeof addr) == 0)
+            return fd;
+        close(fd);
+        nanosleep(&(struct timespec) {0, 100000000}, NULL);
+    }
+    fprintf(stderr, "Can't connect to %s\n", path);
+    return -1;
+}
@@ -0,0 +1,71 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Messages between the coordinator and its workers (see coordinator.h).
+//
+// A message is a type and a payload length, each a 32-bit little-endian
+// integer, followed by the payload.  Payload fields are little-endian
+// integers and length-prefixed byte strings, read and written in order with
+// the functions below.  Nothing depends on the kind of stream that the
+// messages are sent over.
+
+#define PROTOCOL_VERSION 2
+
+#define MAX_MESSAGE_LEN 65536
+
+enum MessageType {
+    MSG_HELLO = 1,      // worker: u32 protocol version, u32 process id
+    MSG_SEARCH,         // coordinator: u32 min girth, n, edge count, first only
+    MSG_LEASE,          // coordinator: u64 lease id, u32 n, edge count, min deg,
+                        //     max deg, then n u64 rows of the graph
+    MSG_RESULT,         // worker: u64 lease id, graph count, canonicalisation calls,
+                        //     u32 number of orders, a u64 visited count for each,
+                        //     then the name of the output file as a string
+    MSG_DONE,           // coordinator: no more leases; empty
+    MSG_DONATE_REQUEST, // coordinator: give away some unvisited graphs; empty
+    MSG_DONATION,       // worker: u64 lease id, u32 number of graphs, then for
+                        //     each, u32 n, edge count, min deg, max deg and
+                        //     n u64 rows
+    MSG_EXCLUDE         // coordinator, before a reissued lease: graphs that were
+                        //     donated from the lease and must be skipped; u32
+                        //     number of graphs, then for each, u32 n and n u64 rows
+};
+
+struct Message {
+    uint32_t type;
+    uint32_t length;
+    size_t pos;         // read position in payload
+    bool overrun;       // set if a read went past the end of the payload
+    unsigned char payload[MAX_MESSAGE_LEN];
+};
+
+void message_init(struct Message *m, enum MessageType type);
+
+void put_u32(struct Message *m, uint32_t x);
+
+void put_u64(struct Message *m, uint64_t x);
+
+void put_string(struct Message *m, char *s);
+
+// These return 0 (or an empty string) and set m->overrun if the payload is
+// too short
+uint32_t get_u32(struct Message *m);
+
+uint64_t get_u64(struct Message *m);
+
+// Copies a string of at most size-1 bytes to s
+void get_string(struct Message *m, char *s, size_t size);
+
+// Return false if the stream fails or ends, or if a received message is
+// malformed
+bool send_message(int fd, struct Message *m);
+
+bool recv_message(int fd, struct Message *m);
+
+// Unix domain sockets, which are currently the only transport
+int listen_unix_socket(char *path);
+
+// Retries for up to timeout_seconds while the socket doesn't exist or
+// isn't accepting connections; returns -1 on failure
+int connect_unix_socket(char *path, int timeout_seconds);
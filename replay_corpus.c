@@ -0,0 +1,169 @@
+// Micro-benchmark drivers that replay a corpus captured with
+// ex_max_canonical_deletions --capture-corpus (see corpus.h) through the
+// kernels of the search, each in isolation, and report the time per call.
+//
+// Usage: ./replay_corpus corpus_file [reps]
+
+#include "graph_plus.h"
+#include "graph_util.h"
+#include "canonical_deletion.h"
+#include "corpus.h"
+#include "util.h"
+
+#include <time.h>
+
+// A sampled graph with one of its candidate neighbour sets added as vertex n-1
+struct Child {
+    int n;
+    int tentativeness_level;
+    int min_deg;
+    int max_deg;
+    int edge_count;
+    setword vertices_of_min_deg;
+    graph g[MAXN];
+    graph canon_g[MAXN];
+};
+
+static struct CorpusRecord *records;
+static int num_records;
+static struct Child *children;
+static int num_children;
+static int max_path_len;
+
+static double elapsed_seconds(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void make_children()
+{
+    children = emalloc(((size_t) num_records * CORPUS_MAX_CANDIDATES + 1) * sizeof *children);
+    num_children = 0;
+    for (int i=0; i<num_records; i++) {
+        struct CorpusRecord *r = &records[i];
+        for (int j=0; j<r->num_candidates; j++) {
+            struct Child *c = &children[num_children++];
+            int n = r->n + 1;
+            setword neighbours = r->candidates[j];
+            c->n = n;
+            c->tentativeness_level = r->tentativeness_level;
+            EMPTYGRAPH(c->g, 1, MAXN);
+            for (int k=0; k<r->n; k++)
+                c->g[k] = r->graph[k];
+            c->g[n-1] = neighbours;
+            while (neighbours) {
+                int nb;
+                TAKEBIT(nb, neighbours);
+                ADDELEMENT(&c->g[nb], n-1);
+            }
+            c->min_deg = POPCOUNT(c->g[n-1]);
+            c->max_deg = 0;
+            c->vertices_of_min_deg = 0;
+            c->edge_count = r->edge_count + c->min_deg;
+            for (int k=0; k<n; k++) {
+                int deg = POPCOUNT(c->g[k]);
+                if (deg > c->max_deg)
+                    c->max_deg = deg;
+                if (deg == c->min_deg)
+                    c->vertices_of_min_deg |= bit[k];
+            }
+            make_canonical(c->g, n, c->canon_g, NULL);
+        }
+    }
+}
+
+static void report(char *name, double secs, long long calls)
+{
+    if (calls == 0)
+        printf("%-32s %10s\n", name, "no calls");
+    else
+        printf("%-32s %10.1f ns/call  (%lld calls)\n", name, secs * 1e9 / calls, calls);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        printf("Required: corpus file.  Optional: number of repetitions.\n");
+        exit(1);
+    }
+    int reps = argc > 2 ? atoi(argv[2]) : 10;
+
+    struct CorpusHeader h;
+    if (!corpus_read(argv[1], &h, &records))
+        exit(1);
+    num_records = h.record_count;
+    max_path_len = h.min_girth - 3;
+    make_children();
+    printf("%d graphs and %d children from a search for girth %u, n %u, %u edges; %d repetitions\n",
+            num_records, num_children, h.min_girth, h.n, h.edge_count, reps);
+
+    setword checksum = 0;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int rep=0; rep<reps; rep++) {
+        for (int i=0; i<num_records; i++) {
+            graph canon_g[MAXN];
+            int lab[MAXN];
+            make_canonical(records[i].graph, records[i].n, canon_g, lab);
+            checksum += canon_g[0];
+        }
+    }
+    report("make_canonical", elapsed_seconds(&start), (long long) reps * num_records);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int rep=0; rep<reps; rep++) {
+        for (int i=0; i<num_records; i++) {
+            setword have_short_path[MAXN];
+            all_pairs_check_for_short_path(records[i].graph, records[i].n, max_path_len, have_short_path);
+            checksum += have_short_path[0];
+        }
+    }
+    report("all_pairs_check_for_short_path", elapsed_seconds(&start), (long long) reps * num_records);
+
+    // Level 0 and higher tentativeness levels are reported separately, since
+    // only level 0 calls nauty
+    for (int tentative=0; tentative<2; tentative++) {
+        long long calls = 0;
+        long long accepted = 0;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int rep=0; rep<reps; rep++) {
+            for (int i=0; i<num_children; i++) {
+                struct Child *c = &children[i];
+                if ((c->tentativeness_level != 0) != tentative)
+                    continue;
+                calls++;
+                accepted += deletion_is_canonical(c->g, c->n, c->min_deg, c->max_deg,
+                        c->tentativeness_level, c->vertices_of_min_deg);
+            }
+        }
+        report(tentative ? "deletion_is_canonical (level > 0)" : "deletion_is_canonical (level 0)",
+                elapsed_seconds(&start), calls);
+        checksum += accepted;
+    }
+
+    // The children of each sampled graph are added to a fresh set, as in
+    // visit_graph
+    long long calls = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int rep=0; rep<reps; rep++) {
+        struct Child *c = children;
+        for (int i=0; i<num_records; i++) {
+            struct GraphPlusSet gp_set = make_gp_set();
+            for (int j=0; j<records[i].num_candidates; j++, c++) {
+                calls++;
+                checksum += gp_set_add(&gp_set, c->canon_g, c->n, c->edge_count,
+                        c->min_deg, c->max_deg) != NULL;
+            }
+            free_tree(&gp_set.tree_head);
+        }
+    }
+    report("gp_set_add (with free_tree)", elapsed_seconds(&start), calls);
+
+    printf("checksum %llu\n", (unsigned long long) checksum);
+
+    free(children);
+    free(records);
+}
@@ -0,0 +1,108 @@
+#include "extremal.h"
+
+#include <stdbool.h>
+#include <signal.h>
+
+// The search, as seen by code outside ex_max_canonical_deletions.c that
+// drives it (see coordinator.h)
+
+extern int global_n;
+extern unsigned long long global_graph_count;
+extern bool global_first_only;
+extern bool global_search_stopped;
+extern unsigned long long num_visited_by_order[MAXN];
+
+// Splitting, as set by the optional command-line arguments; a search with
+// global_low_splitting_level 0 is not split
+extern int global_low_splitting_level;
+extern int global_high_splitting_level;
+extern int global_split_number;
+
+// If global_predicate is non-NULL, only the graphs that it accepts are
+// found, and if it is hereditary, the subtree below any graph that it
+// rejects is pruned (see ExtremalPredicate in extremal.h)
+extern ExtremalPredicate global_predicate;
+extern const char *global_predicate_arg;
+extern bool global_predicate_is_hereditary;
+
+// The degrees that the vertices of the graphs found may have, as a setword;
+// by default, all degrees.  Set before start_search.
+extern setword global_allowed_degrees;
+
+// In regular mode, global_regular_degree is the degree k of the k-regular
+// graphs sought (and global_allowed_degrees should be {k}); otherwise 0
+extern int global_regular_degree;
+
+// In bipartite mode, only bipartite graphs are visited
+extern bool global_bipartite;
+
+// If global_frontier_order is non-zero, each graph of that order that would
+// be visited at tentativeness level 0 is passed to global_frontier_callback
+// instead, and the search goes no deeper.  The graph is only valid for the
+// duration of the call.
+extern int global_frontier_order;
+extern void (*global_frontier_callback)(struct GraphPlus *gp);
+
+// If global_work_requested is set (for example by a signal handler),
+// global_work_request_callback is called at the next visit at tentativeness
+// level 0; it may call donate_pending_children, and should clear the flag
+extern volatile sig_atomic_t global_work_requested;
+extern void (*global_work_request_callback)();
+
+// If global_child_filter is non-NULL, a child found at tentativeness level 0
+// is dropped, along with its subtree, unless global_child_filter returns true
+// for it
+extern bool (*global_child_filter)(struct GraphPlus *gp);
+
+// Budgets for the search: if the wall-clock time since set_budgets exceeds
+// seconds, or the memory held by the frames of the search path for their
+// children exceeds bytes (either 0 for no limit), the search stops between
+// graphs.  Each subtree left unexplored (a child found but not yet visited)
+// is passed to unexplored_callback, and global_budget_exhausted is set to
+// "time" or "memory".  The checks are made every few graphs, so a budget
+// may be overrun by the cost of one visit.
+void set_budgets(double seconds, unsigned long long bytes,
+        void (*unexplored_callback)(struct GraphPlus *gp));
+extern const char *global_budget_exhausted;
+
+// Removes up to max_donated children that have been found but not yet
+// visited from the search, and puts pointers to them in donated.  The
+// children are taken from the right-hand end of the pending children at
+// the lowest order that has any, and about half of them are taken.  The
+// graphs are only valid until the search continues.  Returns the number of
+// children removed.
+int donate_pending_children(struct GraphPlus **donated, int max_donated);
+
+// Sets the parameters of the search, and must be called before search_from
+void start_search(int min_girth, int n, int edge_count);
+
+// Runs the search from gp, which must be canonical, as if gp had just been
+// found as a child in the full search
+void search_from(struct GraphPlus *gp);
+
+// A search that is suspended each time it finds a graph.  The path from the
+// root to the current graph is kept in a fixed array of frames, one per
+// order, rather than on the C stack, so only one search may be in progress
+// at a time.
+struct SearchIter {
+    struct GraphPlus root;
+    bool started;
+    int top;            // the order of the deepest frame, less than root.n if none
+};
+
+// Starts a search from root, as search_from does.  Nothing is visited until
+// the first call of search_iter_next.
+void search_iter_start(struct SearchIter *it, struct GraphPlus *root);
+
+// Starts the whole search, as find_extremal_graphs does.  Returns false if
+// there is nothing to search (in a split shard whose share is empty).
+bool search_iter_start_full(struct SearchIter *it, int min_girth, int n, int edge_count);
+
+// Runs the search until it finds another graph, and returns it, or returns
+// NULL once the search is finished.  The graph is valid until the next call.
+// To abandon a search, set global_search_stopped and call this until it
+// returns NULL.
+struct GraphPlus *search_iter_next(struct SearchIter *it);
+
+// Runs the whole search, from the graph with one vertex
+void find_extremal_graphs(int min_girth, int n, int edge_count);
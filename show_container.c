@@ -0,0 +1,55 @@
+// Prints the header and index of a binary container written with
+// `-f binary`, followed by its graphs (or just graph k) in graph6 format.
+//
+// Usage: ./show_container FILE [k]
+
+#include "graph_plus.h"
+#include "graph_output.h"
+#include "graph_container.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        printf("Required: container file.  Optional: graph number.\n");
+        exit(1);
+    }
+
+    struct Container c;
+    if (!container_open(argv[1], &c))
+        exit(1);
+
+    struct ContainerHeader *h = c.header;
+    printf("min girth %u, n %u, edge count %u, ", h->min_girth, h->n, h->edge_count);
+    if (h->shard_id == CONTAINER_MERGED)
+        printf("merged, ");
+    else
+        printf("shard %u, ", h->shard_id);
+    printf("%llu graphs\n", (unsigned long long) h->graph_count);
+    for (uint32_t i=0; i<h->num_shards; i++)
+        printf("shard %u: graphs %llu to %llu\n", c.index[i].shard_id,
+                (unsigned long long) c.index[i].first_graph,
+                (unsigned long long) (c.index[i].first_graph + c.index[i].graph_count));
+
+    uint64_t first = 0;
+    uint64_t last = h->graph_count;
+    if (argc > 2) {
+        first = strtoull(argv[2], NULL, 10);
+        if (first >= h->graph_count) {
+            printf("There is no graph %llu\n", (unsigned long long) first);
+            exit(1);
+        }
+        last = first + 1;
+    }
+
+    for (uint64_t k=first; k<last; k++) {
+        graph g[MAXN];
+        uint64_t *rows = container_graph(&c, k);
+        for (uint32_t i=0; i<h->n; i++)
+            g[i] = rows[i];
+        char s[MAX_ENCODED_GRAPH_LEN];
+        graph_to_graph6(g, h->n, s);
+        fputs(s, stdout);
+    }
+
+    container_close(&c);
+}
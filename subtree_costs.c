@@ -0,0 +1,73 @@
+#include "graph_plus.h"
+#include "graph_output.h"
+#include "subtree_costs.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+int subtree_costs_order = 0;
+
+static FILE *costs_file;
+static unsigned long long *costs_visited_by_order;
+static unsigned long long *costs_graph_count;
+static long long *costs_canonicalisation_calls;
+
+// The counts when the current subtree was entered
+static unsigned long long start_nodes;
+static unsigned long long start_graph_count;
+static long long start_calls;
+static struct timespec start_time;
+
+void start_subtree_costs(int order, char *filename, unsigned long long *visited_by_order,
+        unsigned long long *graph_count, long long *canonicalisation_calls)
+{
+    costs_file = fopen(filename, "w");
+    if (!costs_file) {
+        printf("Can't open %s for writing\n", filename);
+        exit(1);
+    }
+    fprintf(costs_file, "# graph6 nodes canonicalisation_calls graphs_found seconds\n");
+    subtree_costs_order = order;
+    costs_visited_by_order = visited_by_order;
+    costs_graph_count = graph_count;
+    costs_canonicalisation_calls = canonicalisation_calls;
+}
+
+static unsigned long long nodes_below_root()
+{
+    unsigned long long nodes = 0;
+    for (int i=subtree_costs_order; i<MAXN; i++)
+        nodes += costs_visited_by_order[i];
+    return nodes;
+}
+
+void subtree_costs_enter(struct GraphPlus *gp)
+{
+    start_nodes = nodes_below_root();
+    start_graph_count = *costs_graph_count;
+    start_calls = *costs_canonicalisation_calls;
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+void subtree_costs_leave(struct GraphPlus *gp)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    char s[MAX_ENCODED_GRAPH_LEN];
+    int len = graph_to_graph6(gp->graph, gp->n, s);
+    s[len-1] = '\0';   // the newline
+    fprintf(costs_file, "%s %llu %lld %llu %.6f\n", s,
+            nodes_below_root() - start_nodes,
+            *costs_canonicalisation_calls - start_calls,
+            *costs_graph_count - start_graph_count,
+            (now.tv_sec - start_time.tv_sec) + (now.tv_nsec - start_time.tv_nsec) / 1e9);
+}
+
+void finish_subtree_costs()
+{
+    if (subtree_costs_order && fclose(costs_file) != 0) {
+        printf("Can't write the subtree costs\n");
+        exit(1);
+    }
+    subtree_costs_order = 0;
+}
@@ -0,0 +1,29 @@
+#include <stdio.h>
+
+// A table of what the subtree below each canonical graph of one order
+// costs, for finding the families of graphs that dominate a search and for
+// estimating the cost of shards.
+//
+// The table is text, with a row for each subtree in the order in which the
+// subtrees are left:
+//     graph6 nodes canonicalisation_calls graphs_found seconds
+// where graph6 is the canonical form of the graph at the root of the
+// subtree and nodes counts the graphs visited at tentativeness level 0 in
+// the subtree, including the root.  A subtree that is cut short (for
+// example by --first) has a partial row, and so does one whose children were
+// donated to other workers.
+
+// Records the subtrees rooted at graphs of the given order in filename.  The
+// counters are owned by the caller and are only read.
+void start_subtree_costs(int order, char *filename, unsigned long long *visited_by_order,
+        unsigned long long *graph_count, long long *canonicalisation_calls);
+
+// The order whose subtrees are recorded, or 0 if none
+extern int subtree_costs_order;
+
+// These bracket the visit to a graph of order subtree_costs_order
+void subtree_costs_enter(struct GraphPlus *gp);
+
+void subtree_costs_leave(struct GraphPlus *gp);
+
+void finish_subtree_costs();